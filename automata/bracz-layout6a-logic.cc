@@ -1050,6 +1050,7 @@ int main(int argc, char** argv) {
   assert(f);
   string output;
   brd.Render(&output);
+  brd.Optimize(&output);
   fwrite(output.data(), 1, output.size(), f);
   fclose(f);
 
@@ -81,6 +81,402 @@ void Board::RenderAutomatas(string* output) {
             output->size());
 }
 
+namespace {
+
+/// One row of a rendered automata: the conditions and the actions.
+struct Row {
+  string ifs;
+  string acts;
+  /// Offsets in the rendered program of the rows this one was made of.
+  vector<size_t> offsets;
+};
+
+/// @return the number of bytes of the action at acts[i]. Has to match
+/// AutomataRunner::action_length.
+unsigned ActionLength(const string& acts, size_t i) {
+  uint8_t insn = acts[i];
+  if (insn == _ACT_IMPORT_VAR) return 5;
+  if (insn == _ACT_SET_EVENTID) return 3 + (acts[i + 1] & 7);
+  if (insn == _ACT_DEF_VAR || insn == _ACT_SET_VAR_VALUE) return 3;
+  if ((insn & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) return 2;
+  return 1;
+}
+
+/// @return the global variable and argument referred to by the import
+/// action at acts[i], without the local variable.
+string ImportedVariable(const string& acts, size_t i) {
+  string ret = acts.substr(i + 1, 4);
+  ret[0] &= ~31;
+  return ret;
+}
+
+/// Parses the rows starting at *ip until the terminating zero byte. Leaves
+/// *ip after the terminator.
+vector<Row> ParseRows(const string& program, size_t* ip) {
+  vector<Row> rows;
+  HASSERT(*ip < program.size());
+  while (uint8_t hdr = program[*ip]) {
+    size_t endif = *ip + 1 + (hdr & 0xf);
+    size_t endcond = endif + (hdr >> 4);
+    HASSERT(endcond < program.size());
+    rows.push_back({program.substr(*ip + 1, endif - *ip - 1),
+                    program.substr(endif, endcond - endif), {*ip}});
+    *ip = endcond;
+  }
+  ++*ip;
+  return rows;
+}
+
+void AppendRows(const vector<Row>& rows, string* output) {
+  for (const auto& r : rows) {
+    HASSERT(r.ifs.size() < 16 && r.acts.size() < 16);
+    output->push_back((r.acts.size() << 4) | r.ifs.size());
+    *output += r.ifs;
+    *output += r.acts;
+  }
+  output->push_back(0);
+}
+
+/// Appends to ids the global variable IDs defined by rows when they are
+/// rendered at offset start. The ID of a variable is the offset of the
+/// argument bytes of its _ACT_DEF_VAR.
+void FindVariables(const vector<Row>& rows, size_t start, vector<size_t>* ids) {
+  for (const auto& r : rows) {
+    start += 1 + r.ifs.size();
+    for (size_t i = 0; i < r.acts.size(); i += ActionLength(r.acts, i)) {
+      if (uint8_t(r.acts[i]) == _ACT_DEF_VAR) ids->push_back(start + i + 1);
+    }
+    start += r.acts.size();
+  }
+}
+
+/// Points the imports to the new IDs of the global variables.
+void RelocateImports(const map<uint16_t, size_t>& relocation,
+                     vector<Row>* rows) {
+  for (auto& r : *rows) {
+    for (size_t i = 0; i < r.acts.size(); i += ActionLength(r.acts, i)) {
+      if (uint8_t(r.acts[i]) != _ACT_IMPORT_VAR) continue;
+      uint16_t id = uint8_t(r.acts[i + 3]) | (uint8_t(r.acts[i + 4]) << 8);
+      auto it = relocation.find(id);
+      if (it == relocation.end()) continue;
+      r.acts[i + 3] = it->second & 0xff;
+      r.acts[i + 4] = (it->second >> 8) & 0xff;
+    }
+  }
+}
+
+/// Removes unconditional imports that bind a local variable to the global
+/// variable it is already bound to.
+void DropRepeatedImports(vector<Row>* rows) {
+  // What each local variable is bound to, or empty if not known.
+  string bound[MAX_IMPORT_VAR];
+  for (auto& r : *rows) {
+    string acts;
+    for (size_t i = 0; i < r.acts.size(); i += ActionLength(r.acts, i)) {
+      uint8_t insn = r.acts[i];
+      if (insn == _ACT_DEF_VAR) {
+        // The global variables may now refer to different bits.
+        for (auto& b : bound) b.clear();
+      }
+      if (insn == _ACT_IMPORT_VAR) {
+        unsigned local_id = r.acts[i + 1] & 31;
+        string var = ImportedVariable(r.acts, i);
+        if (r.ifs.empty() && bound[local_id] == var) continue;
+        if (r.ifs.empty()) {
+          bound[local_id] = var;
+        } else {
+          bound[local_id].clear();
+        }
+      }
+      acts.append(r.acts, i, ActionLength(r.acts, i));
+    }
+    r.acts.swap(acts);
+  }
+  vector<Row> out;
+  for (auto& r : *rows) {
+    if (!r.ifs.empty() || !r.acts.empty()) out.push_back(std::move(r));
+  }
+  rows->swap(out);
+}
+
+/// Contents of the two event ID registers of the runner, as far as known.
+struct EventIds {
+  bool known[2] = {false, false};
+  uint64_t value[2] = {0, 0};
+};
+
+/// @return a set event ID action loading value into register dst with the
+/// fewest literal bytes given the known register contents.
+string EncodeSetEventId(int dst, uint64_t value, const EventIds& ids) {
+  int src = dst;
+  unsigned num_bytes = 8;
+  for (int k = 0; k < 2; ++k) {
+    if (!ids.known[k]) continue;
+    uint64_t diff = ids.value[k] ^ value;
+    unsigned n = 1;
+    while (n < 8 && (diff >> (8 * n))) ++n;
+    if (n < num_bytes) {
+      num_bytes = n;
+      src = k;
+    }
+  }
+  string ret;
+  ret.push_back(_ACT_SET_EVENTID);
+  ret.push_back((dst << 6) | (src << 4) | (num_bytes - 1));
+  for (int b = num_bytes - 1; b >= 0; --b) {
+    ret.push_back((value >> (8 * b)) & 0xff);
+  }
+  return ret;
+}
+
+/// Re-encodes the set event ID actions to copy the bytes that the registers
+/// are known to contain already.
+void ShortenEventIds(vector<Row>* rows) {
+  EventIds ids;
+  for (auto& r : *rows) {
+    EventIds in_row = ids;
+    string acts;
+    for (size_t i = 0; i < r.acts.size(); i += ActionLength(r.acts, i)) {
+      if (uint8_t(r.acts[i]) != _ACT_SET_EVENTID) {
+        acts.append(r.acts, i, ActionLength(r.acts, i));
+        continue;
+      }
+      uint8_t arg = r.acts[i + 1];
+      int dst = (arg >> 6) & 1;
+      int src = (arg >> 4) & 1;
+      unsigned num_bytes = (arg & 7) + 1;
+      if (num_bytes < 8 && !in_row.known[src]) {
+        acts.append(r.acts, i, ActionLength(r.acts, i));
+        in_row.known[dst] = false;
+        continue;
+      }
+      uint64_t value = num_bytes < 8 ? in_row.value[src] : 0;
+      for (unsigned k = 0; k < num_bytes; ++k) {
+        int shift = 8 * (num_bytes - 1 - k);
+        value &= ~(0xffULL << shift);
+        value |= uint64_t(uint8_t(r.acts[i + 2 + k])) << shift;
+      }
+      acts += EncodeSetEventId(dst, value, in_row);
+      in_row.known[dst] = true;
+      in_row.value[dst] = value;
+    }
+    r.acts.swap(acts);
+    for (int k = 0; k < 2; ++k) {
+      if (r.ifs.empty()) {
+        ids.known[k] = in_row.known[k];
+        ids.value[k] = in_row.value[k];
+      } else if (!in_row.known[k] || in_row.value[k] != ids.value[k]) {
+        // Depends on whether the row was executed.
+        ids.known[k] = false;
+      }
+    }
+  }
+}
+
+/// @return a bitmask of the local variables that refer to the same bit
+/// during the entire automata and no other local variable refers to that
+/// bit: those imported only unconditionally, always from the same global
+/// variable, and the timer bit.
+uint32_t StaticLocals(const vector<Row>& rows) {
+  string var[MAX_IMPORT_VAR];
+  uint32_t imported = 1;
+  uint32_t dynamic = 0;
+  for (const auto& r : rows) {
+    for (size_t i = 0; i < r.acts.size(); i += ActionLength(r.acts, i)) {
+      uint8_t insn = r.acts[i];
+      if (insn == _ACT_DEF_VAR) return 1;
+      if (insn != _ACT_IMPORT_VAR) continue;
+      unsigned local_id = r.acts[i + 1] & 31;
+      string v = ImportedVariable(r.acts, i);
+      if (!r.ifs.empty() ||
+          ((imported & (1U << local_id)) && var[local_id] != v)) {
+        dynamic |= 1U << local_id;
+      }
+      imported |= 1U << local_id;
+      var[local_id] = v;
+    }
+  }
+  for (unsigned i = 1; i < MAX_IMPORT_VAR; ++i) {
+    for (unsigned j = i + 1; j < MAX_IMPORT_VAR; ++j) {
+      if ((imported & (1U << i)) && (imported & (1U << j)) &&
+          var[i] == var[j]) {
+        dynamic |= (1U << i) | (1U << j);
+      }
+    }
+  }
+  return imported & ~dynamic;
+}
+
+/// @return true if the actions of row may change the outcome of its
+/// conditions, or if this cannot be decided.
+bool ActionsAffectConditions(const Row& row, uint32_t static_locals) {
+  uint64_t read = 0;
+  bool read_state = false;
+  for (uint8_t c : row.ifs) {
+    if ((c & _IF_REG_MASK) == _IF_REG) {
+      read |= 1ULL << (c & _IF_REG_BITNUM_MASK);
+    } else if ((c & _IF_STATE_MASK) == _IF_STATE) {
+      read_state = true;
+    } else {
+      // Locks and misc conditions have side effects or other inputs.
+      return true;
+    }
+  }
+  uint64_t written = 0;
+  bool write_state = false;
+  for (size_t i = 0; i < row.acts.size(); i += ActionLength(row.acts, i)) {
+    uint8_t a = row.acts[i];
+    if ((a & _ACT_REG_MASK) == _ACT_REG) {
+      written |= 1ULL << (a & _IF_REG_BITNUM_MASK);
+    } else if ((a & _ACT_STATE_MASK) == _ACT_STATE) {
+      write_state = true;
+    } else if ((a & _ACT_TIMER_MASK) == _ACT_TIMER) {
+      written |= 1;
+    } else if (a == _ACT_IMPORT_VAR) {
+      written |= 1ULL << (row.acts[i + 1] & 31);
+    } else if (a != _ACT_SET_EVENTID) {
+      return true;
+    }
+  }
+  if (read_state && write_state) return true;
+  uint64_t aliased = ~uint64_t(static_locals);
+  if ((read & aliased) && written) return true;
+  if ((written & aliased) && read) return true;
+  return read & written;
+}
+
+/// @return true if row only has import actions.
+bool IsImportRow(const Row& row) {
+  if (!row.ifs.empty() || row.acts.empty()) return false;
+  for (size_t i = 0; i < row.acts.size(); i += ActionLength(row.acts, i)) {
+    if (uint8_t(row.acts[i]) != _ACT_IMPORT_VAR) return false;
+  }
+  return true;
+}
+
+/// Merges each row into the previous one if that has the same conditions
+/// and its actions do not change the outcome of those conditions.
+void MergeRows(vector<Row>* rows, uint32_t static_locals) {
+  vector<Row> out;
+  for (auto& r : *rows) {
+    if (!out.empty()) {
+      Row& prev = out.back();
+      bool can_merge = prev.ifs == r.ifs &&
+                       prev.acts.size() + r.acts.size() < 16;
+      if (can_merge && r.ifs.empty()) {
+        // The runner resolves rows with only imports ahead of time.
+        can_merge = IsImportRow(prev) == IsImportRow(r);
+      } else if (can_merge) {
+        can_merge = !ActionsAffectConditions(prev, static_locals);
+      }
+      if (can_merge) {
+        prev.acts += r.acts;
+        prev.offsets.insert(prev.offsets.end(), r.offsets.begin(),
+                            r.offsets.end());
+        continue;
+      }
+    }
+    out.push_back(std::move(r));
+  }
+  rows->swap(out);
+}
+
+/// Rewrites the offsets of the "ofs" lines of the debug data using
+/// relocation. Drops the lines of the rows that were removed.
+void RelocateDebugOffsets(const map<size_t, size_t>& relocation) {
+  string* debug = GetDebugData();
+  string out;
+  size_t pos = 0;
+  while (pos < debug->size()) {
+    size_t end = debug->find('\n', pos);
+    end = end == string::npos ? debug->size() : end + 1;
+    string line = debug->substr(pos, end - pos);
+    pos = end;
+    unsigned ofs;
+    int len = 0;
+    if (sscanf(line.c_str(), "ofs %u:%n", &ofs, &len) < 1 || !len) {
+      out += line;
+      continue;
+    }
+    auto it = relocation.find(ofs);
+    if (it == relocation.end()) continue;
+    out += StringPrintf("ofs %zu:", it->second) + line.substr(len);
+  }
+  debug->swap(out);
+}
+
+}  // namespace
+
+void Board::Optimize(string* output) {
+  const string program(*output);
+  const size_t table_size = 2 * automatas_.size() + 2;
+  size_t ip = table_size;
+  // The preamble followed by the automata bodies.
+  vector<vector<Row>> parts;
+  vector<size_t> old_sizes;
+  vector<size_t> old_ids;
+  for (size_t i = 0; i <= automatas_.size(); ++i) {
+    HASSERT(i == 0 || automatas_[i - 1].offset == (int)ip);
+    size_t start = ip;
+    parts.push_back(ParseRows(program, &ip));
+    old_sizes.push_back(ip - start);
+    FindVariables(parts.back(), start, &old_ids);
+    if (i > 0) {
+      DropRepeatedImports(&parts.back());
+    }
+    ShortenEventIds(&parts.back());
+    MergeRows(&parts.back(), i > 0 ? StaticLocals(parts.back()) : 0);
+  }
+  HASSERT(ip == program.size());
+
+  // Global variables are identified by their offset in the program, so the
+  // imports have to follow the definitions to their new place.
+  vector<size_t> new_ids;
+  ip = table_size;
+  for (const auto& rows : parts) {
+    FindVariables(rows, ip, &new_ids);
+    for (const auto& r : rows) ip += 1 + r.ifs.size() + r.acts.size();
+    ++ip;
+  }
+  HASSERT(old_ids.size() == new_ids.size());
+  map<uint16_t, size_t> relocation;
+  for (size_t i = 0; i < old_ids.size(); ++i) {
+    relocation[old_ids[i] & 0xffff] = new_ids[i];
+  }
+  for (auto v : global_variables_) {
+    auto it = relocation.find(v->GetId().id & 0xffff);
+    if (it != relocation.end()) v->SetId(it->second);
+  }
+
+  output->assign(program, 0, table_size);
+  // Where the rows logged by the operations ended up.
+  map<size_t, size_t> debug_relocation;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    RelocateImports(relocation, &parts[i]);
+    size_t start = output->size();
+    size_t row_start = start;
+    for (const auto& r : parts[i]) {
+      for (size_t o : r.offsets) debug_relocation[o] = row_start;
+      row_start += 1 + r.ifs.size() + r.acts.size();
+    }
+    AppendRows(parts[i], output);
+    size_t size = output->size() - start;
+    if (i == 0) {
+      Debug("preamble: %zu bytes, saved %zu", size, old_sizes[i] - size);
+      continue;
+    }
+    auto& a = automatas_[i - 1];
+    a.offset = start;
+    (*output)[a.ptr_offset] = a.offset & 0xff;
+    (*output)[a.ptr_offset + 1] = (a.offset >> 8) & 0xff;
+    Debug("automata %s: %zu bytes, saved %zu", a.automata->name().c_str(),
+          size, old_sizes[i] - size);
+  }
+  RelocateDebugOffsets(debug_relocation);
+  fprintf(stderr, "optimized output size: %zd, saved %zd bytes\n",
+          output->size(), program.size() - output->size());
+}
+
 Automata::LocalVariable* Automata::ImportVariable(GlobalVariable* var) {
     ImportVariable(*var);
     LocalVariable& ret = used_variables_[var];
@@ -50,6 +50,14 @@ public:
     //! Generates the binary data for the entire board.
     void Render(string* output);
 
+    //! Rewrites the binary data generated by Render into a smaller program
+    //! that behaves the same: drops repeated imports, uses the shortest
+    //! encoding for setting event IDs and merges consecutive rows that have
+    //! the same conditions. Logs the bytes saved per automata to the debug
+    //! data and moves the offsets logged for the rows to where the rows
+    //! ended up; the lines of dropped rows are removed.
+    void Optimize(string* output);
+
     void AddAutomata(Automata* a);
 
     void AddVariable(GlobalVariable* v) {
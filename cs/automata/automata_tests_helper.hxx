@@ -55,6 +55,38 @@ class AutomataTests : public openlcb::AsyncNodeTest {
     bool* backend_;
   };
 
+  // A FakeBitPointer that reports changes of the backend to the automatas
+  // reading it, like the event bits do.
+  class FakeTrackedBitPointer : public FakeBitPointer {
+   public:
+    FakeTrackedBitPointer(bool* backend)
+        : FakeBitPointer(backend), backend_(backend), last_value_(*backend) {}
+
+    void Write(uint16_t arg, openlcb::Node* node, Automata* aut,
+               bool value) override {
+      FakeBitPointer::Write(arg, node, aut, value);
+      PollChanges();
+    }
+
+    bool AddDependent(uint16_t, Automata* aut) override {
+      deps_.push_back(aut);
+      return true;
+    }
+
+    void ClearDependents() override { deps_.clear(); }
+
+    void PollChanges() override {
+      if (*backend_ == last_value_) return;
+      last_value_ = *backend_;
+      for (auto* aut : deps_) aut->SetDirty(true);
+    }
+
+   private:
+    bool* backend_;
+    bool last_value_;
+    std::vector<Automata*> deps_;
+  };
+
   class FakeBitReadOnlyPointer : public ReadWriteBit {
    public:
     FakeBitReadOnlyPointer(bool* backend)
@@ -155,10 +187,24 @@ class AutomataTests : public openlcb::AsyncNodeTest {
     virtual uint64_t event_on() const { HASSERT(false); }
     virtual uint64_t event_off() const { HASSERT(false); }
 
+  protected:
+    bool* backend() { return &bit_; }
+
   private:
     bool bit_;
   };
 
+  // A FakeBit that allows the runner to skip automatas when it did not
+  // change.
+  class FakeTrackedBit : public FakeBit {
+  public:
+    FakeTrackedBit(AutomataTests* parent) : FakeBit(parent) {}
+
+    virtual ReadWriteBit* CreateBit() {
+      return new FakeTrackedBitPointer(backend());
+    }
+  };
+
   class FakeROBit : public InjectableVar {
   public:
     FakeROBit(AutomataTests* parent) : InjectableVar(parent), bit_(false) {}
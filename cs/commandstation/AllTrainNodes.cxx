@@ -150,21 +150,19 @@ openlcb::TrainImpl* AllTrainNodes::get_train_impl(int id) {
 }
 
 AllTrainNodes::Impl* AllTrainNodes::find_node(openlcb::Node* node) {
-  for (auto* i : trains_) {
-    if (i->node_ == node) {
-      return i;
-    }
+  auto it = trainsByNode_.find(node);
+  if (it == trainsByNode_.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return it->second;
 }
 
 AllTrainNodes::Impl* AllTrainNodes::find_node(openlcb::NodeID node_id) {
-  for (auto* i : trains_) {
-    if (i->node_->node_id() == node_id) {
-      return i;
-    }
+  auto it = trainsByNodeId_.find(node_id);
+  if (it == trainsByNodeId_.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return it->second;
 }
 
 /// Returns a traindb entry or nullptr if the id is too high.
@@ -501,6 +499,19 @@ void AllTrainNodes::update_config() {
     if (entry) continue;
     // Delete current node.
     trains_[id] = nullptr;
+    openlcb::NodeID node_id = impl->node_->node_id();
+    auto it = trainsByNodeId_.find(node_id);
+    if (it != trainsByNodeId_.end() && it->second == impl) {
+      trainsByNodeId_.erase(it);
+      // Another train with the same node ID takes its place in the index.
+      for (auto* t : trains_) {
+        if (t && t->node_->node_id() == node_id) {
+          trainsByNodeId_.emplace(node_id, t);
+          break;
+        }
+      }
+    }
+    trainsByNode_.erase(impl->node_);
     impl->node_->iface()->delete_local_node(impl->node_);
     delete impl;
     impl = trains_.back();
@@ -606,6 +617,9 @@ AllTrainNodes::Impl* AllTrainNodes::create_impl(int train_id, DccMode mode,
   if (impl->train_) {
     trains_.push_back(impl);
     impl->node_ = new openlcb::TrainNodeForProxy(train_service(), impl->train_);
+    // If two trains have the same node ID, the first one wins.
+    trainsByNodeId_.emplace(impl->node_->node_id(), impl);
+    trainsByNode_[impl->node_] = impl;
     return impl;
   } else {
     delete impl;
@@ -626,6 +640,12 @@ bool AllTrainNodes::find_flow_is_idle() {
   return findProtocolServer_->is_idle();
 }
 
+// For testing.
+bool AllTrainNodes::is_train_node(openlcb::NodeID node_id) {
+  Impl* impl = find_node(node_id);
+  return impl && find_node(impl->node_) == impl;
+}
+
 AllTrainNodes::~AllTrainNodes() {
   for (auto* t : trains_) {
     delete t;
@@ -36,6 +36,7 @@
 #define _BRACZ_COMMANDSTATION_ALLTRAINNODES_HXX_
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "commandstation/AllTrainNodesInterface.hxx"
@@ -81,6 +82,10 @@ class AllTrainNodes : public AllTrainNodesInterface {
   // For testing.
   bool find_flow_is_idle();
 
+  // For testing. Returns true if the node ID is a train node maintained by
+  // this object; looks it up both by node ID and by node.
+  bool is_train_node(openlcb::NodeID node_id);
+
  private:
   // ==== Interface for children ====
   struct Impl;
@@ -106,6 +111,12 @@ class AllTrainNodes : public AllTrainNodesInterface {
   /// All train nodes that we know about.
   std::vector<Impl*> trains_;
 
+  /// Index of trains_ by the node ID of the train node. Every openlcb request
+  /// addressed to a train node is looked up here.
+  std::unordered_map<openlcb::NodeID, Impl*> trainsByNodeId_;
+  /// Index of trains_ by the train node.
+  std::unordered_map<openlcb::Node*, Impl*> trainsByNode_;
+
   friend class FindProtocolServer;
   std::unique_ptr<FindProtocolServer> findProtocolServer_;
 
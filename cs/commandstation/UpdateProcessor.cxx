@@ -26,9 +26,9 @@
  *
  * \file UpdateProcessor.cxx
  *
- * Control flow central to the command station: it round-robins between
- * refreshing the individual trains, while giving priority to the update
- * packets.
+ * Control flow central to the command station: it refreshes the individual
+ * trains in the order of their refresh deadlines, while giving priority to
+ * the update packets.
  *
  * @author Balazs Racz
  * @date 13 May 2014
@@ -37,115 +37,414 @@
 #include "commandstation/UpdateProcessor.hxx"
 
 #include "utils/constants.hxx"
+#include "utils/format_utils.hxx"
+#include "utils/logging.h"
 #include "dcc/PacketSource.hxx"
 #include "dcc/TrackIf.hxx"
 
 namespace commandstation {
 
-// Urgent updates will take BufferBase from this pool to add stuff to the
-// priorityUpdates qlist.
-static Pool* urgent_update_buffer_pool() { return mainBufferPool; }
-
-struct PriorityUpdate {
-  void reset(dcc::PacketSource* source, unsigned code) {
-    this->source = source;
-    this->code = code;
-  }
-  dcc::PacketSource* source;
-  unsigned code;
-};
-
-UpdateProcessor::UpdateProcessor(Service* service,
-                                 dcc::TrackIf* track_send)
+TrackOutput::TrackOutput(Service* service, dcc::TrackIf* track_send)
     : StateFlow<Buffer<dcc::Packet>, QList<1> >(service),
       trackSend_(track_send),
-      nextRefreshIndex_(0),
+      urgentHead_(NO_SLOT),
+      urgentTail_(NO_SLOT),
+      nextOrder_(0),
+      periodHistogram_{},
+      lastHistogramLogTime_(0),
       exclusiveIndex_(NO_EXCLUSIVE),
       hasRefreshSource_(0) {}
 
-UpdateProcessor::~UpdateProcessor() {}
+TrackOutput::~TrackOutput() {}
+
+void TrackOutput::notify(dcc::PacketSource* source, unsigned code) {
+  // Update codes have to fit in the pending mask.
+  HASSERT(code < 32);
+  AtomicHolder l(this);
+  auto it = sourceSlots_.find(source);
+  if (it == sourceSlots_.end()) {
+    // Not a refresh source, there is nobody to send the update to.
+    return;
+  }
+  auto& st = sourceStates_[it->second];
+  if (!st.routed_) {
+    // The train is not on this output.
+    return;
+  }
+  st.pendingCodes_ |= 1u << code;
+  if (!st.urgentQueued_) {
+    urgent_push(it->second);
+  }
+}
 
-void UpdateProcessor::notify_update(dcc::PacketSource* source, unsigned code) {
-  Buffer<PriorityUpdate>* b;
-  urgent_update_buffer_pool()->alloc(&b, nullptr);
-  HASSERT(b);
-  b->data()->reset(source, code);
+void TrackOutput::set_routed(dcc::PacketSource* source, bool routed) {
   AtomicHolder l(this);
-  priorityUpdates_.insert(b, 0);
+  auto it = sourceSlots_.find(source);
+  if (it == sourceSlots_.end()) return;
+  unsigned slot = it->second;
+  auto& st = sourceStates_[slot];
+  if (st.routed_ == routed) return;
+  st.routed_ = routed;
+  if (routed) {
+    // The decoder may not have seen a packet for a long time.
+    st.deadline_ = 0;
+    st.order_ = ++nextOrder_;
+    heap_push(slot);
+  } else {
+    heap_remove(slot);
+    urgent_remove(slot);
+  }
+  update_refresh_sources();
+}
+
+void TrackOutput::update_refresh_sources() {
+  // Recomputes which is the largest priority and whether we have exclusive.
+  unsigned max_priority = dcc::UpdateLoopBase::EXCLUSIVE_MIN_PRIORITY;
+  unsigned max_index = NO_EXCLUSIVE;
+  hasRefreshSource_ = 0;
+  for (unsigned i = 0; i < refreshSources_.size(); ++i) {
+    const auto& st = sourceStates_[refreshSources_[i]];
+    if (!st.routed_) continue;
+    hasRefreshSource_ = 1;
+    if (st.priority_ >= max_priority) {
+      max_index = i;
+      max_priority = st.priority_;
+    }
+  }
+  exclusiveIndex_ = max_index;
 }
 
 DECLARE_CONST(dcc_packet_min_refresh_delay_ms);
+DECLARE_CONST(dcc_packet_active_refresh_ms);
+DECLARE_CONST(dcc_packet_idle_refresh_ms);
+DECLARE_CONST(dcc_packet_active_source_ms);
 
-StateFlowBase::Action UpdateProcessor::entry() {
+StateFlowBase::Action TrackOutput::entry() {
   // We have an empty packet to fill. It is accessible in message()->data().
   dcc::PacketSource* s = nullptr;
-  Buffer<PriorityUpdate>* b = nullptr;
+  unsigned slot = 0;
+  unsigned code = 0;
+  long long now = os_get_time_monotonic();
+  long long min_time =
+      now - MSEC_TO_NSEC(config_dcc_packet_min_refresh_delay_ms());
   {
     AtomicHolder h(this);
     // First we check if there is an exclusive update.
     if (has_exclusive()) {
-      s = refreshSources_[exclusiveIndex_];
-    } else {
+      slot = refreshSources_[exclusiveIndex_];
+      s = sourceStates_[slot].source_;
+    } else if (urgentHead_ != NO_SLOT) {
       // Then we check if there is an urgent update.
-      b = static_cast<Buffer<PriorityUpdate>*>(priorityUpdates_.next().item);
-    }
-  }
-  long long now = os_get_time_monotonic();
-  unsigned code = 0;
-  if (b) {
-    // found a priority entry.
-    s = b->data()->source;
-    code = b->data()->code;
-    auto it = packetSourceStates_.find(s);
-    if (it == packetSourceStates_.end()) {
-      // This packet source has been removed. Do not call it!
-      b->unref();
-      s = nullptr;
-    } else if (it->second.lastPacketTime_ >
-               (now - MSEC_TO_NSEC(config_dcc_packet_min_refresh_delay_ms()))) {
-      // Last update for this loco is too recent. Let's put it back to the
-      // queue.
-      {
-        AtomicHolder h(this);
-        priorityUpdates_.insert(b, 0);
+      unsigned urgent = urgentHead_;
+      auto& st = sourceStates_[urgent];
+      urgent_pop();
+      if (st.lastPacketTime_ > min_time) {
+        // Last update for this loco is too recent. Let's put it back to the
+        // queue.
+        urgent_push(urgent);
+      } else {
+        slot = urgent;
+        s = st.source_;
+        code = __builtin_ctz(st.pendingCodes_);
+        st.pendingCodes_ &= ~(1u << code);
+        st.lastUpdateTime_ = now;
+        if (st.pendingCodes_) {
+          // The other codes go after the updates of other sources.
+          urgent_push(urgent);
+        }
       }
-      s = nullptr;
-    } else {
-      b->unref();
     }
   }
   if (!s && hasRefreshSource_) {
-    // No new update. Find the next background source.
-    unsigned ntries = 0;
-    while (ntries++ < refreshSources_.size()) {
-      {
-        AtomicHolder h(this);
-        if (nextRefreshIndex_ >= refreshSources_.size()) {
-          nextRefreshIndex_ = 0;
-        }
-        s = refreshSources_[nextRefreshIndex_++];
-        code = 0;
-      }
-      if (packetSourceStates_[s].lastPacketTime_ <
-          (now - MSEC_TO_NSEC(config_dcc_packet_min_refresh_delay_ms()))) {
-        break;
-      } else {
-        s = nullptr;
-      }
+    // No new update. Active sources that are due go first, then idle sources
+    // that are due. If nobody is due, the least recently sent source gets the
+    // spare packet, so that idle sources are not starved by the shorter
+    // deadlines of the active ones.
+    AtomicHolder h(this);
+    unsigned active = next_refresh(ACTIVE_SOURCE, min_time);
+    unsigned idle = next_refresh(IDLE_SOURCE, min_time);
+    if (active == NO_SLOT) {
+      slot = idle;
+    } else if (idle == NO_SLOT || sourceStates_[active].deadline_ <= now) {
+      slot = active;
+    } else if (sourceStates_[idle].deadline_ <= now) {
+      slot = idle;
+    } else if (sourceStates_[idle].lastPacketTime_ <
+               sourceStates_[active].lastPacketTime_) {
+      slot = idle;
+    } else {
+      slot = active;
+    }
+    if (slot != NO_SLOT) {
+      s = sourceStates_[slot].source_;
+      code = 0;
     }
   }
   if (s) {
     // requests next packet from that source.
     s->get_next_packet(code, message()->data());
-    packetSourceStates_[s].lastPacketTime_ = now;
+    packet_sent(slot, now);
   } else {
     // No update, no source. We are idle!
     //bracz_custom::send_host_log_event(bracz_custom::HostLogEvent::TRACK_IDLE);
     message()->data()->set_dcc_idle();
   }
+  log_refresh_periods(now);
   // We pass on the filled packet to the track processor.
   trackSend_->send(transfer_message());
   return exit();
 }
 
+void TrackOutput::packet_sent(unsigned slot, long long now) {
+  AtomicHolder h(this);
+  auto& st = sourceStates_[slot];
+  SourceClass c = IDLE_SOURCE;
+  if (st.lastUpdateTime_ &&
+      now - st.lastUpdateTime_ <
+          MSEC_TO_NSEC(config_dcc_packet_active_source_ms())) {
+    c = ACTIVE_SOURCE;
+  }
+  if (st.lastPacketTime_) {
+    long long period = now - st.lastPacketTime_;
+    unsigned bucket = 0;
+    while (bucket < NUM_PERIOD_BUCKETS - 1 &&
+           period >= (MSEC_TO_NSEC(25) << bucket)) {
+      ++bucket;
+    }
+    ++periodHistogram_[c][bucket];
+  }
+  st.lastPacketTime_ = now;
+  st.deadline_ = now + MSEC_TO_NSEC(c == ACTIVE_SOURCE
+                                        ? config_dcc_packet_active_refresh_ms()
+                                        : config_dcc_packet_idle_refresh_ms());
+  st.order_ = ++nextOrder_;
+  if (st.class_ == c) {
+    heap_update(slot);
+  } else {
+    heap_remove(slot);
+    st.class_ = c;
+    heap_push(slot);
+  }
+}
+
+void TrackOutput::urgent_push(unsigned slot) {
+  auto& st = sourceStates_[slot];
+  st.urgentQueued_ = true;
+  st.nextUrgent_ = NO_SLOT;
+  if (urgentHead_ == NO_SLOT) {
+    urgentHead_ = slot;
+  } else {
+    sourceStates_[urgentTail_].nextUrgent_ = slot;
+  }
+  urgentTail_ = slot;
+}
+
+void TrackOutput::urgent_pop() {
+  auto& st = sourceStates_[urgentHead_];
+  st.urgentQueued_ = false;
+  urgentHead_ = st.nextUrgent_;
+}
+
+void TrackOutput::urgent_remove(unsigned slot) {
+  auto& st = sourceStates_[slot];
+  st.pendingCodes_ = 0;
+  if (!st.urgentQueued_) return;
+  st.urgentQueued_ = false;
+  if (urgentHead_ == slot) {
+    urgentHead_ = st.nextUrgent_;
+    return;
+  }
+  unsigned prev = urgentHead_;
+  while (sourceStates_[prev].nextUrgent_ != slot) {
+    prev = sourceStates_[prev].nextUrgent_;
+  }
+  sourceStates_[prev].nextUrgent_ = st.nextUrgent_;
+  if (urgentTail_ == slot) {
+    urgentTail_ = prev;
+  }
+}
+
+unsigned TrackOutput::next_refresh(SourceClass c, long long min_time) {
+  const auto& heap = refreshHeap_[c];
+  unsigned ret = NO_SLOT;
+  for (unsigned i = 0; i < 3 && i < heap.size(); ++i) {
+    if (sourceStates_[heap[i]].lastPacketTime_ >= min_time) continue;
+    if (ret == NO_SLOT || heap_less(heap[i], ret)) {
+      ret = heap[i];
+    }
+  }
+  return ret;
+}
+
+void TrackOutput::log_refresh_periods(long long now) {
+  if (!lastHistogramLogTime_) {
+    lastHistogramLogTime_ = now;
+    return;
+  }
+  if (now - lastHistogramLogTime_ < SEC_TO_NSEC(60)) return;
+  lastHistogramLogTime_ = now;
+  static const char* const names[NUM_SOURCE_CLASSES] = {"active", "idle"};
+  for (unsigned c = 0; c < NUM_SOURCE_CLASSES; ++c) {
+    string line;
+    for (unsigned i = 0; i < NUM_PERIOD_BUCKETS; ++i) {
+      line += ' ';
+      line += integer_to_string(periodHistogram_[c][i]);
+    }
+    LOG(INFO, "dcc refresh periods (%s, 25 msec * 2^i buckets):%s", names[c],
+        line.c_str());
+  }
+}
+
+void TrackOutput::heap_push(unsigned slot) {
+  auto* heap = &refreshHeap_[sourceStates_[slot].class_];
+  sourceStates_[slot].heapIndex_ = heap->size();
+  heap->push_back(slot);
+  heap_sift_up(heap, heap->size() - 1);
+}
+
+void TrackOutput::heap_remove(unsigned slot) {
+  auto* heap = &refreshHeap_[sourceStates_[slot].class_];
+  unsigned i = sourceStates_[slot].heapIndex_;
+  unsigned last = heap->back();
+  heap->pop_back();
+  if (i >= heap->size()) return;
+  (*heap)[i] = last;
+  sourceStates_[last].heapIndex_ = i;
+  heap_update(last);
+}
+
+void TrackOutput::heap_update(unsigned slot) {
+  auto* heap = &refreshHeap_[sourceStates_[slot].class_];
+  unsigned i = sourceStates_[slot].heapIndex_;
+  if (i > 0 && heap_less(slot, (*heap)[(i - 1) / 2])) {
+    heap_sift_up(heap, i);
+  } else {
+    heap_sift_down(heap, i);
+  }
+}
+
+void TrackOutput::heap_sift_up(vector<unsigned>* heap, unsigned i) {
+  unsigned slot = (*heap)[i];
+  while (i > 0) {
+    unsigned parent = (i - 1) / 2;
+    if (!heap_less(slot, (*heap)[parent])) break;
+    (*heap)[i] = (*heap)[parent];
+    sourceStates_[(*heap)[i]].heapIndex_ = i;
+    i = parent;
+  }
+  (*heap)[i] = slot;
+  sourceStates_[slot].heapIndex_ = i;
+}
+
+void TrackOutput::heap_sift_down(vector<unsigned>* heap, unsigned i) {
+  unsigned slot = (*heap)[i];
+  while (true) {
+    unsigned child = 2 * i + 1;
+    if (child >= heap->size()) break;
+    if (child + 1 < heap->size() &&
+        heap_less((*heap)[child + 1], (*heap)[child])) {
+      ++child;
+    }
+    if (!heap_less((*heap)[child], slot)) break;
+    (*heap)[i] = (*heap)[child];
+    sourceStates_[(*heap)[i]].heapIndex_ = i;
+    i = child;
+  }
+  (*heap)[i] = slot;
+  sourceStates_[slot].heapIndex_ = i;
+}
+
+UpdateProcessor::UpdateProcessor(Service* service, dcc::TrackIf* track_send)
+    : TrackOutput(service, track_send) {}
+
+UpdateProcessor::~UpdateProcessor() {}
+
+bool UpdateProcessor::add_refresh_source(dcc::PacketSource* source,
+                                         unsigned priority) {
+  bool ret = add_source(source, priority);
+  for (auto* o : outputs_) {
+    o->add_source(source, priority);
+  }
+  uint32_t outputs = ALL_OUTPUTS;
+  {
+    AtomicHolder h(this);
+    auto it = sourceOutputs_.find(source);
+    if (it != sourceOutputs_.end()) {
+      // The location was set before the source was registered.
+      outputs = it->second;
+    }
+  }
+  if (outputs != ALL_OUTPUTS) {
+    route_source(source, outputs);
+  }
+  return ret;
+}
+
+void UpdateProcessor::remove_refresh_source(dcc::PacketSource* source) {
+  remove_source(source);
+  for (auto* o : outputs_) {
+    o->remove_source(source);
+  }
+  AtomicHolder h(this);
+  sourceOutputs_.erase(source);
+}
+
+void UpdateProcessor::notify_update(dcc::PacketSource* source,
+                                    unsigned code) {
+  notify(source, code);
+  for (auto* o : outputs_) {
+    o->notify(source, code);
+  }
+}
+
+void UpdateProcessor::add_output(TrackOutput* output) {
+  struct Source {
+    dcc::PacketSource* source;
+    unsigned priority;
+    bool routed;
+  };
+  vector<Source> sources;
+  {
+    AtomicHolder h(this);
+    // Output numbers have to fit in the mask of set_source_outputs.
+    HASSERT(outputs_.size() < 31);
+    outputs_.push_back(output);
+    uint32_t bit = 1u << outputs_.size();
+    for (unsigned slot : refreshSources_) {
+      const auto& st = sourceStates_[slot];
+      auto it = sourceOutputs_.find(st.source_);
+      sources.push_back(
+          {st.source_, st.priority_,
+           it == sourceOutputs_.end() || (it->second & bit) != 0});
+    }
+  }
+  for (const auto& s : sources) {
+    output->add_source(s.source, s.priority);
+    if (!s.routed) {
+      output->set_routed(s.source, false);
+    }
+  }
+}
+
+void UpdateProcessor::set_source_outputs(dcc::PacketSource* source,
+                                         uint32_t outputs) {
+  {
+    AtomicHolder h(this);
+    if (outputs == ALL_OUTPUTS) {
+      sourceOutputs_.erase(source);
+    } else {
+      sourceOutputs_[source] = outputs;
+    }
+  }
+  route_source(source, outputs);
+}
+
+void UpdateProcessor::route_source(dcc::PacketSource* source,
+                                   uint32_t outputs) {
+  set_routed(source, outputs & 1);
+  for (unsigned i = 0; i < outputs_.size(); ++i) {
+    outputs_[i]->set_routed(source, (outputs >> (i + 1)) & 1);
+  }
+}
+
 }  // namespace commandstation
@@ -26,9 +26,9 @@
  *
  * \file UpdateProcessor.hxx
  *
- * Control flow central to the command station: it round-robins between
- * refreshing the individual trains, while giving priority to the update
- * packets.
+ * Control flow central to the command station: it refreshes the individual
+ * trains in the order of their refresh deadlines, while giving priority to
+ * the update packets.
  *
  * @author Balazs Racz
  * @date 13 May 2014
@@ -51,32 +51,54 @@ class PacketSource;
 
 namespace commandstation {
 
-/** This state flow is responsible for filling empty packets with useful data
- * from the packet sources. It receives empty packets from the track interface
- * throttler on its input, fills these packets by calling into the packet
- * sources (aka train implementations), and sends the full packets to the track
- * interface for actually rendering them . */
-class UpdateProcessor : public StateFlow<Buffer<dcc::Packet>, QList<1> >,
-                        private dcc::UpdateLoopBase {
+/** This state flow is responsible for filling empty packets of one track
+ * output with useful data from the packet sources. It receives empty packets
+ * from the track interface throttler on its input, fills these packets by
+ * calling into the packet sources (aka train implementations), and sends the
+ * full packets to the track interface for actually rendering them. The set of
+ * packet sources is managed by the UpdateProcessor, which owns the first track
+ * output and forwards the sources to all other outputs. */
+class TrackOutput : public StateFlow<Buffer<dcc::Packet>, QList<1> > {
  public:
-  UpdateProcessor(Service* service, dcc::TrackIf* track_send);
-  ~UpdateProcessor();
+  TrackOutput(Service* service, dcc::TrackIf* track_send);
+  ~TrackOutput();
 
-  /** Adds a new refresh source to the background refresh packets. */
-  bool add_refresh_source(dcc::PacketSource* source,
-                          unsigned priority) OVERRIDE {
+  /** Adds a new refresh source to the background refresh packets.
+   *
+   * @return false if this source will not get packets because there is an
+   * exclusive source with a higher priority. */
+  bool add_source(dcc::PacketSource* source, unsigned priority) {
     AtomicHolder h(this);
     bool ret = true;
-    refreshSources_.push_back(source);
-    hasRefreshSource_ = 1;
-    auto& s = packetSourceStates_[source];
+    unsigned slot;
+    if (freeSlots_.empty()) {
+      slot = sourceStates_.size();
+      sourceStates_.emplace_back();
+    } else {
+      slot = freeSlots_.back();
+      freeSlots_.pop_back();
+    }
+    auto& s = sourceStates_[slot];
+    s.source_ = source;
     s.priority_ = priority;
     s.lastPacketTime_ = 0;
-    if (priority >= EXCLUSIVE_MIN_PRIORITY) {
+    s.lastUpdateTime_ = 0;
+    // New sources are due for a refresh right away.
+    s.deadline_ = 0;
+    s.order_ = ++nextOrder_;
+    s.class_ = IDLE_SOURCE;
+    s.pendingCodes_ = 0;
+    s.urgentQueued_ = false;
+    s.routed_ = true;
+    sourceSlots_[source] = slot;
+    refreshSources_.push_back(slot);
+    heap_push(slot);
+    hasRefreshSource_ = 1;
+    if (priority >= dcc::UpdateLoopBase::EXCLUSIVE_MIN_PRIORITY) {
       unsigned last_priority = 0;
       if (exclusiveIndex_ != NO_EXCLUSIVE) {
         last_priority =
-            packetSourceStates_[refreshSources_[exclusiveIndex_]].priority_;
+            sourceStates_[refreshSources_[exclusiveIndex_]].priority_;
       }
       if (priority > last_priority) {
         exclusiveIndex_ = refreshSources_.size() - 1;
@@ -91,30 +113,32 @@ class UpdateProcessor : public StateFlow<Buffer<dcc::Packet>, QList<1> >,
     return ret;
   }
   /** Deletes a packet refresh source. */
-  void remove_refresh_source(dcc::PacketSource* source) OVERRIDE {
+  void remove_source(dcc::PacketSource* source) {
     AtomicHolder h(this);
     refreshSources_.erase(
-        remove(refreshSources_.begin(), refreshSources_.end(), source),
+        remove_if(refreshSources_.begin(), refreshSources_.end(),
+                  [this, source](unsigned slot) {
+                    if (sourceStates_[slot].source_ != source) return false;
+                    if (sourceStates_[slot].routed_) {
+                      heap_remove(slot);
+                      urgent_remove(slot);
+                    }
+                    sourceStates_[slot].source_ = nullptr;
+                    freeSlots_.push_back(slot);
+                    return true;
+                  }),
         refreshSources_.end());
-    if (refreshSources_.empty()) {
-      hasRefreshSource_ = 0;
-    }
-    packetSourceStates_.erase(source);
-    // Recomputes which is the largest priority and whether we have exclusive.
-    unsigned max_priority = EXCLUSIVE_MIN_PRIORITY;
-    unsigned max_index = NO_EXCLUSIVE;
-    for (unsigned i = 0; i < refreshSources_.size(); ++i) {
-      const auto& st = packetSourceStates_[refreshSources_[i]];
-      if (st.priority_ >= max_priority) {
-        max_index = i;
-        max_priority = st.priority_;
-      }
-    }
-    exclusiveIndex_ = max_index;
+    sourceSlots_.erase(source);
+    update_refresh_sources();
   }
 
   /** Notifies that a packet source has an urgent packet. */
-  void notify_update(dcc::PacketSource* source, unsigned code) OVERRIDE;
+  void notify(dcc::PacketSource* source, unsigned code);
+
+  /** Sets whether a packet source gets packets on this output. Sources that
+   * are not routed here get neither refresh nor urgent packets; when they are
+   * routed here again, they are due for a refresh right away. */
+  void set_routed(dcc::PacketSource* source, bool routed);
 
   // Entry to the state flow -- when a new packet needs to be sent.
   Action entry() OVERRIDE;
@@ -124,35 +148,149 @@ class UpdateProcessor : public StateFlow<Buffer<dcc::Packet>, QList<1> >,
     trackSend_ = track_send;
   }
 
+  /// Classes of packet sources. Each class has its own refresh deadline.
+  enum SourceClass {
+    /// Sources that had an urgent update recently, such as trains that are
+    /// being driven.
+    ACTIVE_SOURCE = 0,
+    /// All other sources, such as parked trains.
+    IDLE_SOURCE,
+    NUM_SOURCE_CLASSES
+  };
+
+  /// Number of buckets in the refresh period histograms.
+  static constexpr unsigned NUM_PERIOD_BUCKETS = 10;
+
+  /// @return the histogram of the time between two consecutive packets sent
+  /// to the same source, for sources of a given class. Bucket i counts
+  /// periods shorter than 25 msec * 2^i that do not fit in bucket i-1. The
+  /// last bucket also counts all longer periods.
+  const uint32_t* refresh_period_histogram(SourceClass c) {
+    return periodHistogram_[c];
+  }
+
  private:
+  /// Reads the registered sources when adding another output.
+  friend class UpdateProcessor;
+
   struct SourceState {
+    /// The packet source in this slot, or nullptr if the slot is free.
+    dcc::PacketSource* source_;
     /// Stores the last time we sent a packet to a given loco. Suppresses
     /// refresh packet if this time is too recent to avoid confusing DCC
     /// decoders.
     long long lastPacketTime_;
+    /// The last time this source had an urgent update, or 0 if never.
+    long long lastUpdateTime_;
+    /// The time by which this source should get a refresh packet.
+    long long deadline_;
+    /// Breaks ties between equal deadlines in the order they were set.
+    uint32_t order_;
+    /// Position of this slot in refreshHeap_[class_].
+    unsigned heapIndex_;
+    /// Which class this source was in when it was last sent a packet.
+    SourceClass class_;
     /// Priority of packet source. This also encodes whether this is an
     /// exclusive packet source.
     unsigned priority_;
+    /// Bit i is set if there is an urgent update with code i for this
+    /// source that was not sent yet.
+    uint32_t pendingCodes_;
+    /// Next slot in the urgent queue after this one, if urgentQueued_.
+    unsigned nextUrgent_;
+    /// True if this slot is in the urgent queue.
+    bool urgentQueued_;
+    /// False if this source does not get packets on this output. Such
+    /// sources are neither in the refresh heaps nor in the urgent queue.
+    bool routed_;
   };
 
+  /// Recomputes whether we have any refresh sources and which is the highest
+  /// priority exclusive source. Only routed sources are considered.
+  void update_refresh_sources();
+
+  /// Records that a packet was sent to the source in a slot, and computes
+  /// when it needs the next refresh.
+  void packet_sent(unsigned slot, long long now);
+
+  /// Logs the refresh period histograms once in a while.
+  void log_refresh_periods(long long now);
+
+  /// @return true if slot a needs to be refreshed before slot b.
+  bool heap_less(unsigned a, unsigned b) {
+    const auto& sa = sourceStates_[a];
+    const auto& sb = sourceStates_[b];
+    return sa.deadline_ < sb.deadline_ ||
+           (sa.deadline_ == sb.deadline_ &&
+            int32_t(sa.order_ - sb.order_) < 0);
+  }
+  /// Adds a slot to the tail of the urgent queue.
+  void urgent_push(unsigned slot);
+  /// Removes the slot at the head of the urgent queue.
+  void urgent_pop();
+  /// Removes a slot from the urgent queue if it is there.
+  void urgent_remove(unsigned slot);
+
+  /// @return the slot that should get the next refresh packet from the heap
+  /// of a source class, or NO_SLOT if none of its sources may be sent a packet
+  /// before min_time. The earliest deadline may be one that was sent a packet
+  /// too recently; then one of its children in the heap takes its place.
+  unsigned next_refresh(SourceClass c, long long min_time);
+  /// Adds a slot to the refresh heap of its class.
+  void heap_push(unsigned slot);
+  /// Removes a slot from the refresh heap of its class.
+  void heap_remove(unsigned slot);
+  /// Restores the heap order after the deadline of a slot changed.
+  void heap_update(unsigned slot);
+  /// Moves the entry at position i towards the root of the heap as long as
+  /// needed.
+  void heap_sift_up(vector<unsigned>* heap, unsigned i);
+  /// Moves the entry at position i towards the leaves of the heap as long as
+  /// needed.
+  void heap_sift_down(vector<unsigned>* heap, unsigned i);
+
   /// @return if we have an exclusive source.
   bool has_exclusive() { return exclusiveIndex_ != NO_EXCLUSIVE; }
 
   /// Place where we forward the packets filled in.
   dcc::TrackIf* trackSend_;
 
-  /// Holds the list of train nodes that have reported a change. We will always
-  /// take a train node from this list first before starting background refresh.
-  QList<1> priorityUpdates_;
+  /// Holds the list of train nodes that have reported a change, as a linked
+  /// list of slots through SourceState::nextUrgent_. Each source is in the
+  /// list at most once, with all its pending update codes. We will always take
+  /// a train node from this list first before starting background refresh.
+  unsigned urgentHead_;
+  /// Last slot in the urgent queue, if urgentHead_ is not NO_SLOT.
+  unsigned urgentTail_;
 
-  /// Packet sources to ask about refreshing data periodically.
-  vector<dcc::PacketSource*> refreshSources_;
+  /// Packet sources to ask about refreshing data periodically, as slots in
+  /// sourceStates_.
+  vector<unsigned> refreshSources_;
 
-  /// Stores additional data about each packet source.
-  map<dcc::PacketSource*, SourceState> packetSourceStates_;
+  /// Stores additional data about each packet source. Indexed by slot, so
+  /// that sending a packet does not need to look up the source.
+  vector<SourceState> sourceStates_;
+
+  /// Slots in sourceStates_ that are not used by any source.
+  vector<unsigned> freeSlots_;
+
+  /// Slot of each packet source. Only used when adding or removing sources
+  /// and for urgent updates.
+  map<dcc::PacketSource*, unsigned> sourceSlots_;
+
+  /// Slots of the packet sources of each class in a binary heap ordered by
+  /// refresh deadline.
+  vector<unsigned> refreshHeap_[NUM_SOURCE_CLASSES];
+
+  /// Counter for SourceState::order_.
+  uint32_t nextOrder_;
+
+  /// Refresh period histograms for each source class.
+  uint32_t periodHistogram_[NUM_SOURCE_CLASSES][NUM_PERIOD_BUCKETS];
+
+  /// When we last logged the refresh period histograms.
+  long long lastHistogramLogTime_;
 
-  /// Which is the next guy on the refresh source list to add.
-  unsigned nextRefreshIndex_ : 15;
   /// The highest priority refresh index, if we have a exclusive index.
   unsigned exclusiveIndex_ : 15;
   /// Non-zero if we have any refresh sources.
@@ -161,6 +299,63 @@ class UpdateProcessor : public StateFlow<Buffer<dcc::Packet>, QList<1> >,
   /// This is stored in the exclusiveIndex_ when we have no exclusive refresh
   /// source.
   static constexpr unsigned NO_EXCLUSIVE = 0x7FF;
+
+  /// Marks an empty urgent queue, or no source to refresh in next_refresh.
+  static constexpr unsigned NO_SLOT = 0xFFFFFFFFu;
+};
+
+/** The packet processor of the command station. This is the first track
+ * output. It receives the packet sources (aka train implementations) and
+ * forwards them to every additional track output, such as the boosters of
+ * separate layout districts. Each packet source is broadcast to all outputs,
+ * unless its location is known, in which case it is only sent packets on the
+ * outputs that feed that location. */
+class UpdateProcessor : public TrackOutput, private dcc::UpdateLoopBase {
+ public:
+  UpdateProcessor(Service* service, dcc::TrackIf* track_send);
+  ~UpdateProcessor();
+
+  /** Adds a new refresh source to the background refresh packets. */
+  bool add_refresh_source(dcc::PacketSource* source,
+                          unsigned priority) OVERRIDE;
+  /** Deletes a packet refresh source. */
+  void remove_refresh_source(dcc::PacketSource* source) OVERRIDE;
+  /** Notifies that a packet source has an urgent packet. */
+  void notify_update(dcc::PacketSource* source, unsigned code) OVERRIDE;
+
+  /** Adds another track output. It will get all packet sources that are
+   * already registered and all that are added later. Output number i (used
+   * as bit i in set_source_outputs) is the i-th added output; output 0 is
+   * the UpdateProcessor itself. At most 31 outputs may be added. Call this
+   * during initialization.
+   *
+   * @param output is the track output, externally owned. */
+  void add_output(TrackOutput* output);
+
+  /** Sets which track outputs a packet source gets packets on, based on
+   * where the locomotive is on the layout. Nothing in the command station
+   * knows the locations; the target has to call this from its occupancy
+   * detection, otherwise every source is broadcast to all outputs.
+   *
+   * @param source is a packet source. If it is not registered yet, the
+   * outputs take effect when it is added with add_refresh_source. Removing
+   * the source forgets its outputs.
+   * @param outputs is a bit mask of the output numbers. Use ALL_OUTPUTS when
+   * the location of the locomotive is not known (anymore). */
+  void set_source_outputs(dcc::PacketSource* source, uint32_t outputs);
+
+  /// Output mask that broadcasts a packet source to every track output.
+  static constexpr uint32_t ALL_OUTPUTS = 0xFFFFFFFFu;
+
+ private:
+  /// Sets the routed flag of a packet source on every track output.
+  void route_source(dcc::PacketSource* source, uint32_t outputs);
+
+  /// Additional track outputs. Output number i + 1 is outputs_[i].
+  vector<TrackOutput*> outputs_;
+  /// Track outputs of the packet sources whose location is known. Sources
+  /// that are not in here are broadcast to all outputs.
+  map<dcc::PacketSource*, uint32_t> sourceOutputs_;
 };
 
 }  // namespace commandstation
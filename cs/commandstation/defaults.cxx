@@ -1,3 +1,10 @@
 #include "utils/constants.hxx"
 
 DEFAULT_CONST(dcc_packet_min_refresh_delay_ms, 10);
+// Background refresh deadline for packet sources that had an urgent update
+// recently, such as trains being driven.
+DEFAULT_CONST(dcc_packet_active_refresh_ms, 250);
+// Background refresh deadline for all other packet sources.
+DEFAULT_CONST(dcc_packet_idle_refresh_ms, 2000);
+// How long a packet source counts as active after an urgent update.
+DEFAULT_CONST(dcc_packet_active_source_ms, 30000);
@@ -140,6 +140,48 @@ class GlobalVariableReference : public LocalVariableReference {
   }
 };
 
+/// Reference to a static variable, which lives in the static variable array
+/// of the block and is accessed directly by the VM.
+class StaticVariableReference : public VariableReference {
+ public:
+  StaticVariableReference(string name, int slot)
+      : name_(std::move(name)), slot_(slot) {}
+
+  void serialize_fetch(std::string* output) override {
+    BytecodeStream::append_opcode(output, LOAD_STATIC);
+    BytecodeStream::append_varint(output, slot_);
+  }
+
+  void serialize_store(std::string* output) override {
+    BytecodeStream::append_opcode(output, STORE_STATIC);
+    BytecodeStream::append_varint(output, slot_);
+  }
+
+  void serialize_ref(std::string* output) override {
+    BytecodeStream::append_opcode(output, CREATE_INDIRECT_STATIC);
+    BytecodeStream::append_varint(output, slot_);
+  }
+
+  /// Print the variable representation to the sebug string.
+  void debug_print(std::string* output) override {
+    output->append(name_);
+  }
+
+  const string& get_name() {
+    return name_;
+  }
+
+  /// @return the slot of the variable in the static variable array.
+  int get_slot() {
+    return slot_;
+  }
+
+ private:
+  std::string name_;
+  /// Index in the static variable array of the block.
+  int slot_;
+};
+
 /// Compound command (aka brace enclosed command sequence).
 class CommandSequence : public Command {
  public:
@@ -239,18 +281,16 @@ class IndirectVarCreate : public Command {
 
 class StaticVarCreate : public Command {
  public:
-  StaticVarCreate(std::string name, TypeSpecifier type, int guid, int fp_offset,
+  StaticVarCreate(std::string name, TypeSpecifier type, int slot,
                   std::shared_ptr<Command> initial_value)
-      : guid_(guid),
-        type_(type),
-        variable_(name, fp_offset),
+      : type_(type),
+        variable_(name, slot),
         init_(std::move(initial_value)) {}
 
   void serialize(std::string* output) override {
-    BytecodeStream::append_opcode(output, CREATE_STATIC_VAR);
-    BytecodeStream::append_varint(output, guid_);
-    // Now there are two values on the stack: <bottom> = indirect var
-    // offset. <top> = 0 if no init is necessary, 1 if init is necessary.
+    BytecodeStream::append_opcode(output, INIT_STATIC);
+    BytecodeStream::append_varint(output, variable_.get_slot());
+    // Now the top of the stack is 1 if init is necessary, 0 if not.
     string init;
     init_->serialize(&init);
     variable_.serialize_store(&init);
@@ -269,12 +309,10 @@ class StaticVarCreate : public Command {
   }
   
  private:
-  /// Guild of the variable to create and import.
-  int guid_;
   // Variable (syntactic) type.
   TypeSpecifier type_;
   /// Holds the metadata of the variable.
-  GlobalVariableReference variable_;
+  StaticVariableReference variable_;
   // Code that initializes the value.
   std::shared_ptr<Command> init_; 
 };
@@ -1001,6 +1039,24 @@ class Terminate : public Command {
   };
 };
 
+/// Marks the source line of the commands following it.
+class SourceLine : public Command {
+ public:
+  SourceLine(unsigned line) : line_(line) {}
+
+  void serialize(std::string* output) override {
+    BytecodeStream::append_opcode(output, SOURCE_LINE);
+    BytecodeStream::append_varint(output, line_);
+  };
+  void debug_print(std::string* output) override {
+    output->append(StringPrintf("line %u", line_));
+  };
+
+ private:
+  /// Line number in the source.
+  unsigned line_;
+};
+
 } // namespace logic
 
 #endif // _LOGIC_AST_HXX_
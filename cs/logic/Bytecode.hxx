@@ -39,6 +39,7 @@
 #include <inttypes.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "utils/macros.h"
 
@@ -97,6 +98,9 @@ struct Symbol {
   /// relative offset on the operand stack from the fp. Negative for a function
   /// in case the
   int fp_offset_{-1};
+  /// For static variables, the slot in the static variable array of the
+  /// block.
+  int static_slot_{-1};
   /// If this is a function, argument list to it.
   std::weak_ptr<typename FunctionArgList::element_type> args_;  
   /// @todo add declaration location.
@@ -170,13 +174,23 @@ enum OpCode : uint8_t {
   /// variable (of arg2 states).
   CREATE_VAR,
 
-  /// Creates a static variable. arg = GUID of the variable (under which it
-  /// will be stored). The variable will be entered to the variable stack
-  /// (equivalent to IMPORT), and the offset is pushed onto the operand
-  /// stack. Another value will be pushed to the op stack, 0 if there was not
-  /// yet a variable under this GUID and it was newly created, or 0 if the
-  /// variable aready existed.
-  CREATE_STATIC_VAR,
+  /// arg = slot of a static variable in the current block. Pushes 1 to the
+  /// operand stack if the slot was not initialized since the code of the
+  /// block was set, 0 otherwise. Then marks the slot initialized.
+  INIT_STATIC,
+
+  /// arg = slot of a static variable in the current block. Pushes the value
+  /// of the static variable to the operand stack.
+  LOAD_STATIC,
+
+  /// arg = slot of a static variable in the current block. Pops the operand
+  /// stack and writes the value to the static variable.
+  STORE_STATIC,
+
+  /// arg = slot of a static variable in the current block. Creates a new
+  /// variable pointing to the static variable and pushes it to the variable
+  /// stack. The offset in the variable stack is pushed to the operand stack.
+  CREATE_INDIRECT_STATIC,
   
   /// Imports a variable. On the operand stack lhs = GUID of variable; rhs =
   /// argument. The created variable is pushed to the variable stack. The
@@ -244,13 +258,38 @@ enum OpCode : uint8_t {
 
   // Takes the string accumulator and prints it to the "output"
   PRINT_STR,
+
+  /// Marks that the following instructions were generated from the source
+  /// line in the varint argument. Does nothing at runtime. The optimizer
+  /// removes these and turns them into a SourceLineTable.
+  SOURCE_LINE,
   
   NOP = 0xff,
 };
 
+/// Maps a range of bytecode to the source line it was compiled from.
+struct SourceLineEntry {
+  /// Offset in the bytecode of the block where the range starts. The range
+  /// ends at the offset of the next entry.
+  unsigned offset;
+  /// Line number in the source, 0 if unknown.
+  unsigned line;
+};
+
+/// Source line information of a block, sorted by offset.
+typedef std::vector<SourceLineEntry> SourceLineTable;
+
 struct BytecodeStream {
   /// Appends a varint encoding value to a string.
   static void append_varint(std::string* output, int value);
+  /// Decodes a varint from a byte buffer.
+  /// @param ip points to the first byte of the varint. Will be advanced past
+  /// the varint.
+  /// @param eof is the end of the buffer.
+  /// @param output the data goes here.
+  /// @return true if a varint was successfully read; false if eof was hit.
+  static bool decode_varint(const uint8_t** ip, const uint8_t* eof,
+                            int* output);
   /// Appends an opcode to a string.
   static void append_opcode(std::string* output, OpCode opcode) {
     output->push_back(opcode);
@@ -0,0 +1,391 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file CxxTranslator.cxx
+ *
+ * Translates the bytecode of a logic block to C++ source code.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include "logic/CxxTranslator.hxx"
+
+#include <vector>
+
+#include "logic/Bytecode.hxx"
+#include "utils/StringPrintf.hxx"
+
+namespace logic {
+
+namespace {
+
+/// One instruction of the bytecode.
+struct TranslatedInsn {
+  OpCode opcode;
+  /// First operand. For jumps the byte offset of the target.
+  int arg{0};
+  /// Second operand (only for CREATE_VAR).
+  int arg2{0};
+  /// Argument of LOAD_STRING.
+  std::string str;
+  /// Byte offset of this instruction.
+  unsigned ofs;
+  /// Byte offset of the next instruction.
+  unsigned next_ofs;
+};
+
+/// Renders a string as a C string literal.
+std::string quote(const std::string& data) {
+  std::string ret = "\"";
+  for (char c : data) {
+    if (c == '"' || c == '\\' || c == '?' || c < 0x20 || c > 0x7e) {
+      // Octal escapes are at most three digits long, so the next character
+      // cannot be mistaken to be part of it.
+      ret += StringPrintf("\\%03o", (unsigned)(uint8_t)c);
+    } else {
+      ret.push_back(c);
+    }
+  }
+  ret.push_back('"');
+  return ret;
+}
+
+/// Decodes a bytecode into instructions.
+/// @return false if the bytecode is not valid.
+bool decode(const std::string& code, std::vector<TranslatedInsn>* insns) {
+  const uint8_t* start = (const uint8_t*)code.data();
+  const uint8_t* eof = start + code.size();
+  const uint8_t* ip = start;
+  while (ip < eof) {
+    TranslatedInsn d;
+    d.ofs = ip - start;
+    d.opcode = (OpCode)*ip++;
+    switch (d.opcode) {
+      case TERMINATE:
+      case PUSH_CONSTANT_0:
+      case PUSH_CONSTANT_1:
+      case PUSH_TOP:
+      case POP_OP:
+      case INDIRECT_LOAD:
+      case INDIRECT_STORE:
+      case IMPORT_VAR:
+      case NUMERIC_PLUS:
+      case NUMERIC_MINUS:
+      case NUMERIC_MUL:
+      case NUMERIC_DIV:
+      case NUMERIC_MOD:
+      case BOOL_EQ:
+      case BOOL_NEQ:
+      case NUMERIC_LEQ:
+      case NUMERIC_GEQ:
+      case NUMERIC_LT:
+      case NUMERIC_GT:
+      case NUMERIC_EQ:
+      case NUMERIC_NEQ:
+      case BOOL_NOT:
+      case BOOL_PROJECT:
+      case IF_PREAMBLE:
+      case RET:
+      case PRINT_NUM:
+      case PRINT_STR:
+      case NOP:
+        break;
+      case PUSH_CONSTANT:
+      case ENTER:
+      case LEAVE:
+      case CHECK_STACK_LENGTH:
+      case STORE_FP_REL:
+      case LOAD_FP_REL:
+      case INIT_STATIC:
+      case LOAD_STATIC:
+      case STORE_STATIC:
+      case CREATE_INDIRECT_STATIC:
+      case CREATE_INDIRECT_VAR:
+      case JUMP:
+      case CALL:
+      case TEST_JUMP_IF_FALSE:
+      case TEST_JUMP_IF_TRUE:
+      case SOURCE_LINE:
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg)) return false;
+        break;
+      case CREATE_VAR:
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg)) return false;
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg2)) return false;
+        break;
+      case LOAD_STRING: {
+        int len;
+        if (!BytecodeStream::decode_varint(&ip, eof, &len)) return false;
+        if (len < 0 || ip + len > eof) return false;
+        d.str.assign((const char*)ip, len);
+        ip += len;
+        break;
+      }
+      default:
+        return false;
+    }
+    d.next_ofs = ip - start;
+    insns->push_back(std::move(d));
+  }
+  // Resolves the jump targets to byte offsets. The rules are the same as
+  // in the pre-decoder of the VM.
+  std::vector<bool> is_insn_start(code.size() + 1, false);
+  for (const auto& d : *insns) {
+    is_insn_start[d.ofs] = true;
+  }
+  // End of the code.
+  is_insn_start[code.size()] = true;
+  for (auto& d : *insns) {
+    int target = d.next_ofs + d.arg;
+    switch (d.opcode) {
+      case JUMP:
+        if (target < 0 || target > (int)code.size()) return false;
+        break;
+      case TEST_JUMP_IF_FALSE:
+      case TEST_JUMP_IF_TRUE:
+        if (target < 0) return false;
+        if (target > (int)code.size()) target = code.size();
+        break;
+      default:
+        continue;
+    }
+    if (!is_insn_start[target]) return false;
+    d.arg = target;
+  }
+  return true;
+}
+
+} // namespace
+
+// static
+bool CxxTranslator::translate(const std::string& code, std::string* output) {
+  std::vector<TranslatedInsn> insns;
+  if (!decode(code, &insns)) {
+    return false;
+  }
+  bool has_transfer = false;
+  bool has_test = false;
+  for (const auto& d : insns) {
+    if (d.opcode == CALL || d.opcode == RET) has_transfer = true;
+    if (d.opcode == TEST_JUMP_IF_FALSE || d.opcode == TEST_JUMP_IF_TRUE) {
+      has_test = true;
+    }
+  }
+
+  std::string& o = *output;
+  o += "// Generated by logic2cxx. Do not edit.\n\n";
+  o += "#include \"logic/NativeRuntime.hxx\"\n\n";
+  o += "namespace {\n\n";
+  o += "/// Bytecode this code was translated from.\n";
+  o += "const char bytecode[] =";
+  for (unsigned i = 0; i < code.size(); i += 16) {
+    o += "\n    " + quote(code.substr(i, 16));
+  }
+  if (code.empty()) o += " \"\"";
+  o += ";\n\n";
+
+  o += "bool run(logic::NativeRuntime* rt, unsigned ofs) {\n";
+  if (has_transfer) o += "  bool jumped;\n";
+  if (has_test) o += "  int value;\n";
+  if (has_transfer) o += "dispatch:\n";
+  o += "  switch (ofs) {\n";
+  for (const auto& d : insns) {
+    o += StringPrintf("    case %u: goto L%u;\n", d.ofs, d.ofs);
+  }
+  o += StringPrintf("    case %u: goto L%u;\n", (unsigned)code.size(),
+                    (unsigned)code.size());
+  o += "    default: return rt->interpret(ofs);\n";
+  o += "  }\n";
+  if (has_transfer) {
+    o += "transfer:\n";
+    o += "  if (!rt->resume(&ofs)) return rt->interpret();\n";
+    o += "  goto dispatch;\n";
+  }
+
+  for (const auto& d : insns) {
+    o += StringPrintf("L%u:\n  rt->count(%u);\n", d.ofs, d.ofs);
+    std::string fallback = StringPrintf(" return rt->fallback(%u);\n", d.ofs);
+    // Renders a call that returns false if the instruction failed.
+    auto checked = [&o, &fallback](const std::string& call) {
+      o += "  if (!rt->" + call + ")" + fallback;
+    };
+    switch (d.opcode) {
+      case TERMINATE:
+        o += StringPrintf("  return rt->terminate(%u);\n", d.next_ofs);
+        break;
+      case PUSH_CONSTANT:
+        o += StringPrintf("  rt->push(%d);\n", d.arg);
+        break;
+      case PUSH_CONSTANT_0:
+        o += "  rt->push(0);\n";
+        break;
+      case PUSH_CONSTANT_1:
+        o += "  rt->push(1);\n";
+        break;
+      case PUSH_TOP:
+        checked("push_top()");
+        break;
+      case POP_OP:
+        checked("pop_op()");
+        break;
+      case ENTER:
+        o += StringPrintf("  rt->enter(%d);\n", d.arg);
+        break;
+      case LEAVE:
+        checked(StringPrintf("leave(%d)", d.arg));
+        break;
+      case CHECK_STACK_LENGTH:
+        checked(StringPrintf("check_stack_length(%d)", d.arg));
+        break;
+      case STORE_FP_REL:
+        checked(StringPrintf("store_fp_rel(%d)", d.arg));
+        break;
+      case LOAD_FP_REL:
+        checked(StringPrintf("load_fp_rel(%d)", d.arg));
+        break;
+      case INDIRECT_LOAD:
+        checked(StringPrintf("indirect_load(%u)", d.next_ofs));
+        break;
+      case INDIRECT_STORE:
+        checked(StringPrintf("indirect_store(%u)", d.next_ofs));
+        break;
+      case LOAD_STRING:
+        o += StringPrintf("  rt->load_string(%s, %u);\n", quote(d.str).c_str(),
+                          (unsigned)d.str.size());
+        break;
+      case CREATE_VAR:
+        checked(StringPrintf("create_var(%d, %d, %u)", d.arg, d.arg2,
+                             d.next_ofs));
+        break;
+      case INIT_STATIC:
+        checked(StringPrintf("init_static(%d)", d.arg));
+        break;
+      case LOAD_STATIC:
+        checked(StringPrintf("load_static(%d)", d.arg));
+        break;
+      case STORE_STATIC:
+        checked(StringPrintf("store_static(%d)", d.arg));
+        break;
+      case CREATE_INDIRECT_STATIC:
+        o += StringPrintf("  rt->create_indirect_static(%d);\n", d.arg);
+        break;
+      case IMPORT_VAR:
+        checked("import_var()");
+        break;
+      case CREATE_INDIRECT_VAR:
+        o += StringPrintf("  rt->create_indirect_var(%d);\n", d.arg);
+        break;
+      case NUMERIC_PLUS:
+        checked("numeric_plus()");
+        break;
+      case NUMERIC_MINUS:
+        checked("numeric_minus()");
+        break;
+      case NUMERIC_MUL:
+        checked("numeric_mul()");
+        break;
+      case NUMERIC_DIV:
+        checked("numeric_div()");
+        break;
+      case NUMERIC_MOD:
+        checked("numeric_mod()");
+        break;
+      case BOOL_EQ:
+        checked("bool_eq()");
+        break;
+      case BOOL_NEQ:
+        checked("bool_neq()");
+        break;
+      case NUMERIC_LEQ:
+        checked("numeric_leq()");
+        break;
+      case NUMERIC_GEQ:
+        checked("numeric_geq()");
+        break;
+      case NUMERIC_LT:
+        checked("numeric_lt()");
+        break;
+      case NUMERIC_GT:
+        checked("numeric_gt()");
+        break;
+      case NUMERIC_EQ:
+        checked("numeric_eq()");
+        break;
+      case NUMERIC_NEQ:
+        checked("numeric_neq()");
+        break;
+      case BOOL_NOT:
+        checked("bool_not()");
+        break;
+      case BOOL_PROJECT:
+        checked("bool_project()");
+        break;
+      case IF_PREAMBLE:
+        o += "  rt->if_preamble();\n";
+        break;
+      case JUMP:
+        o += StringPrintf("  goto L%d;\n", d.arg);
+        break;
+      case CALL:
+        checked(StringPrintf("call(%d, %u, &jumped)", d.arg, d.next_ofs));
+        o += "  if (jumped) goto transfer;\n";
+        break;
+      case RET:
+        checked(StringPrintf("ret(%u, &jumped)", d.next_ofs));
+        o += "  if (jumped) goto transfer;\n";
+        break;
+      case TEST_JUMP_IF_FALSE:
+        checked("pop(&value)");
+        o += StringPrintf("  if (value == 0) goto L%d;\n", d.arg);
+        break;
+      case TEST_JUMP_IF_TRUE:
+        checked("pop(&value)");
+        o += StringPrintf("  if (value != 0) goto L%d;\n", d.arg);
+        break;
+      case PRINT_NUM:
+        checked("print_num()");
+        break;
+      case PRINT_STR:
+        o += "  rt->print_str();\n";
+        break;
+      default:
+        // SOURCE_LINE and NOP do nothing.
+        break;
+    }
+  }
+  // Running off the end of the code terminates the block.
+  o += StringPrintf("L%u:\n  rt->count(%u);\n  return rt->terminate(%u);\n",
+                    (unsigned)code.size(), (unsigned)code.size(),
+                    (unsigned)code.size());
+  o += "}\n\n";
+  o += "logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, "
+       "nullptr};\n";
+  o += "logic::NativeBlockRegistration registration(&block);\n\n";
+  o += "} // namespace\n";
+  return true;
+}
+
+} // namespace logic
@@ -0,0 +1,65 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file CxxTranslator.hxx
+ *
+ * Translates the bytecode of a logic block to C++ source code.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#ifndef _LOGIC_CXXTRANSLATOR_HXX_
+#define _LOGIC_CXXTRANSLATOR_HXX_
+
+#include <string>
+
+namespace logic {
+
+/// Translates the bytecode of a logic block ahead of time into a C++
+/// translation unit. The generated code executes the same instructions as
+/// the VM, but without the instruction dispatch: every instruction becomes a
+/// call to an inline method of NativeRuntime, and the jumps become gotos.
+///
+/// The translation unit registers the translated block (see
+/// NativeBlock.hxx), so when linked into the binary or loaded as a shared
+/// object, every VM uses it instead of the interpreter for a block with the
+/// same bytecode. Variables are still created through the VariableFactory.
+class CxxTranslator {
+ public:
+  /// Translates a block.
+  /// @param code is the bytecode of the block, as given to
+  /// VM::set_block_code().
+  /// @param output the generated C++ source is appended here.
+  /// @return false if the bytecode contains something the translator does
+  /// not understand (e.g. unknown opcode or a jump into the middle of an
+  /// instruction). Then nothing was appended to output.
+  static bool translate(const std::string& code, std::string* output);
+};
+
+} // namespace logic
+
+#endif // _LOGIC_CXXTRANSLATOR_HXX_
@@ -0,0 +1,2403 @@
+// Generated by the CxxTranslatorTest.DISABLED_print_test_blocks test.
+// Do not edit.
+
+#ifndef _LOGIC_CXXTRANSLATORTESTBLOCKS_HXX_
+#define _LOGIC_CXXTRANSLATORTESTBLOCKS_HXX_
+
+#include "logic/NativeRuntime.hxx"
+
+namespace translated {
+
+namespace block0 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "\001\005\001\003\030.\003,\002\003\002\033";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 2: goto L2;
+    case 4: goto L4;
+    case 5: goto L5;
+    case 6: goto L6;
+    case 7: goto L7;
+    case 9: goto L9;
+    case 10: goto L10;
+    case 11: goto L11;
+    case 12: goto L12;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->push(5);
+L2:
+  rt->count(2);
+  rt->push(3);
+L4:
+  rt->count(4);
+  if (!rt->numeric_plus()) return rt->fallback(4);
+L5:
+  rt->count(5);
+  if (!rt->print_num()) return rt->fallback(5);
+L6:
+  rt->count(6);
+  rt->push(1);
+L7:
+  rt->count(7);
+  if (!rt->pop(&value)) return rt->fallback(7);
+  if (value == 0) goto L11;
+L9:
+  rt->count(9);
+  rt->push(1);
+L10:
+  rt->count(10);
+  rt->push(0);
+L11:
+  rt->count(11);
+  if (!rt->numeric_div()) return rt->fallback(11);
+L12:
+  rt->count(12);
+  return rt->terminate(12);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block0
+
+namespace block1 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001\017\010\001\012\000\001\002\032\012"
+    "\000\001\003\042,\005\003\011\001\010\002\012\000.\012\001"
+    ".\012\000\001\004\034.\002\012\000\001\002\033\031.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 17: goto L17;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 27: goto L27;
+    case 29: goto L29;
+    case 30: goto L30;
+    case 32: goto L32;
+    case 33: goto L33;
+    case 35: goto L35;
+    case 37: goto L37;
+    case 38: goto L38;
+    case 39: goto L39;
+    case 40: goto L40;
+    case 42: goto L42;
+    case 44: goto L44;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 47: goto L47;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(15);
+L8:
+  rt->count(8);
+  if (!rt->check_stack_length(1)) return rt->fallback(8);
+L10:
+  rt->count(10);
+  if (!rt->load_fp_rel(0)) return rt->fallback(10);
+L12:
+  rt->count(12);
+  rt->push(2);
+L14:
+  rt->count(14);
+  if (!rt->numeric_mul()) return rt->fallback(14);
+L15:
+  rt->count(15);
+  if (!rt->load_fp_rel(0)) return rt->fallback(15);
+L17:
+  rt->count(17);
+  rt->push(3);
+L19:
+  rt->count(19);
+  if (!rt->numeric_gt()) return rt->fallback(19);
+L20:
+  rt->count(20);
+  if (!rt->pop(&value)) return rt->fallback(20);
+  if (value == 0) goto L27;
+L22:
+  rt->count(22);
+  rt->push(1);
+L23:
+  rt->count(23);
+  if (!rt->store_fp_rel(1)) return rt->fallback(23);
+L25:
+  rt->count(25);
+  if (!rt->check_stack_length(2)) return rt->fallback(25);
+L27:
+  rt->count(27);
+  if (!rt->load_fp_rel(0)) return rt->fallback(27);
+L29:
+  rt->count(29);
+  if (!rt->print_num()) return rt->fallback(29);
+L30:
+  rt->count(30);
+  if (!rt->load_fp_rel(1)) return rt->fallback(30);
+L32:
+  rt->count(32);
+  if (!rt->print_num()) return rt->fallback(32);
+L33:
+  rt->count(33);
+  if (!rt->load_fp_rel(0)) return rt->fallback(33);
+L35:
+  rt->count(35);
+  rt->push(4);
+L37:
+  rt->count(37);
+  if (!rt->numeric_mod()) return rt->fallback(37);
+L38:
+  rt->count(38);
+  if (!rt->print_num()) return rt->fallback(38);
+L39:
+  rt->count(39);
+  rt->push(0);
+L40:
+  rt->count(40);
+  if (!rt->load_fp_rel(0)) return rt->fallback(40);
+L42:
+  rt->count(42);
+  rt->push(2);
+L44:
+  rt->count(44);
+  if (!rt->numeric_div()) return rt->fallback(44);
+L45:
+  rt->count(45);
+  if (!rt->numeric_minus()) return rt->fallback(45);
+L46:
+  rt->count(46);
+  if (!rt->print_num()) return rt->fallback(46);
+L47:
+  rt->count(47);
+  return rt->terminate(47);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block1
+
+namespace block2 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001\003\010\001\001\007\012\000\012\001"
+    "!,\004\003.\010\002\012\000\012\001 ,\007\001\002"
+    ".\010\002)\023\012\000\001\003$,\007\001\003.\010"
+    "\002)\005\001\004.\010\002";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 16: goto L16;
+    case 17: goto L17;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 21: goto L21;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 27: goto L27;
+    case 28: goto L28;
+    case 30: goto L30;
+    case 32: goto L32;
+    case 33: goto L33;
+    case 35: goto L35;
+    case 37: goto L37;
+    case 39: goto L39;
+    case 41: goto L41;
+    case 42: goto L42;
+    case 44: goto L44;
+    case 46: goto L46;
+    case 47: goto L47;
+    case 49: goto L49;
+    case 51: goto L51;
+    case 53: goto L53;
+    case 54: goto L54;
+    case 56: goto L56;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(3);
+L8:
+  rt->count(8);
+  if (!rt->check_stack_length(1)) return rt->fallback(8);
+L10:
+  rt->count(10);
+  rt->push(7);
+L12:
+  rt->count(12);
+  if (!rt->load_fp_rel(0)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  if (!rt->load_fp_rel(1)) return rt->fallback(14);
+L16:
+  rt->count(16);
+  if (!rt->numeric_lt()) return rt->fallback(16);
+L17:
+  rt->count(17);
+  if (!rt->pop(&value)) return rt->fallback(17);
+  if (value == 0) goto L23;
+L19:
+  rt->count(19);
+  rt->push(1);
+L20:
+  rt->count(20);
+  if (!rt->print_num()) return rt->fallback(20);
+L21:
+  rt->count(21);
+  if (!rt->check_stack_length(2)) return rt->fallback(21);
+L23:
+  rt->count(23);
+  if (!rt->load_fp_rel(0)) return rt->fallback(23);
+L25:
+  rt->count(25);
+  if (!rt->load_fp_rel(1)) return rt->fallback(25);
+L27:
+  rt->count(27);
+  if (!rt->numeric_geq()) return rt->fallback(27);
+L28:
+  rt->count(28);
+  if (!rt->pop(&value)) return rt->fallback(28);
+  if (value == 0) goto L37;
+L30:
+  rt->count(30);
+  rt->push(2);
+L32:
+  rt->count(32);
+  if (!rt->print_num()) return rt->fallback(32);
+L33:
+  rt->count(33);
+  if (!rt->check_stack_length(2)) return rt->fallback(33);
+L35:
+  rt->count(35);
+  goto L56;
+L37:
+  rt->count(37);
+  if (!rt->load_fp_rel(0)) return rt->fallback(37);
+L39:
+  rt->count(39);
+  rt->push(3);
+L41:
+  rt->count(41);
+  if (!rt->numeric_neq()) return rt->fallback(41);
+L42:
+  rt->count(42);
+  if (!rt->pop(&value)) return rt->fallback(42);
+  if (value == 0) goto L51;
+L44:
+  rt->count(44);
+  rt->push(3);
+L46:
+  rt->count(46);
+  if (!rt->print_num()) return rt->fallback(46);
+L47:
+  rt->count(47);
+  if (!rt->check_stack_length(2)) return rt->fallback(47);
+L49:
+  rt->count(49);
+  goto L56;
+L51:
+  rt->count(51);
+  rt->push(4);
+L53:
+  rt->count(53);
+  if (!rt->print_num()) return rt->fallback(53);
+L54:
+  rt->count(54);
+  if (!rt->check_stack_length(2)) return rt->fallback(54);
+L56:
+  rt->count(56);
+  return rt->terminate(56);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block2
+
+namespace block3 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\021\020\003foo\021\000\177\020\003bar"
+    "\021\001\177\000\002\002\026\003\002\026\010\002\012\000\013'"
+    "\012\000\013-\005\012\001\013,\014\012\000\013&'\012"
+    "\001\014\010\003)\006\002\012\001\014\010\003\012\000\013&"
+    "'\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 8: goto L8;
+    case 11: goto L11;
+    case 16: goto L16;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 21: goto L21;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 24: goto L24;
+    case 25: goto L25;
+    case 26: goto L26;
+    case 28: goto L28;
+    case 30: goto L30;
+    case 31: goto L31;
+    case 32: goto L32;
+    case 34: goto L34;
+    case 35: goto L35;
+    case 37: goto L37;
+    case 39: goto L39;
+    case 40: goto L40;
+    case 42: goto L42;
+    case 44: goto L44;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 47: goto L47;
+    case 49: goto L49;
+    case 50: goto L50;
+    case 52: goto L52;
+    case 54: goto L54;
+    case 55: goto L55;
+    case 57: goto L57;
+    case 58: goto L58;
+    case 60: goto L60;
+    case 62: goto L62;
+    case 63: goto L63;
+    case 64: goto L64;
+    case 65: goto L65;
+    case 67: goto L67;
+    case 68: goto L68;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L20;
+L3:
+  rt->count(3);
+  rt->load_string("foo", 3);
+L8:
+  rt->count(8);
+  if (!rt->create_var(0, -1, 11)) return rt->fallback(8);
+L11:
+  rt->count(11);
+  rt->load_string("bar", 3);
+L16:
+  rt->count(16);
+  if (!rt->create_var(1, -1, 19)) return rt->fallback(16);
+L19:
+  rt->count(19);
+  return rt->terminate(20);
+L20:
+  rt->count(20);
+  rt->push(0);
+L21:
+  rt->count(21);
+  rt->push(0);
+L22:
+  rt->count(22);
+  if (!rt->import_var()) return rt->fallback(22);
+L23:
+  rt->count(23);
+  rt->push(1);
+L24:
+  rt->count(24);
+  rt->push(0);
+L25:
+  rt->count(25);
+  if (!rt->import_var()) return rt->fallback(25);
+L26:
+  rt->count(26);
+  if (!rt->check_stack_length(2)) return rt->fallback(26);
+L28:
+  rt->count(28);
+  if (!rt->load_fp_rel(0)) return rt->fallback(28);
+L30:
+  rt->count(30);
+  if (!rt->indirect_load(31)) return rt->fallback(30);
+L31:
+  rt->count(31);
+  if (!rt->bool_project()) return rt->fallback(31);
+L32:
+  rt->count(32);
+  if (!rt->load_fp_rel(0)) return rt->fallback(32);
+L34:
+  rt->count(34);
+  if (!rt->indirect_load(35)) return rt->fallback(34);
+L35:
+  rt->count(35);
+  if (!rt->pop(&value)) return rt->fallback(35);
+  if (value != 0) goto L42;
+L37:
+  rt->count(37);
+  if (!rt->load_fp_rel(1)) return rt->fallback(37);
+L39:
+  rt->count(39);
+  if (!rt->indirect_load(40)) return rt->fallback(39);
+L40:
+  rt->count(40);
+  if (!rt->pop(&value)) return rt->fallback(40);
+  if (value == 0) goto L54;
+L42:
+  rt->count(42);
+  if (!rt->load_fp_rel(0)) return rt->fallback(42);
+L44:
+  rt->count(44);
+  if (!rt->indirect_load(45)) return rt->fallback(44);
+L45:
+  rt->count(45);
+  if (!rt->bool_not()) return rt->fallback(45);
+L46:
+  rt->count(46);
+  if (!rt->bool_project()) return rt->fallback(46);
+L47:
+  rt->count(47);
+  if (!rt->load_fp_rel(1)) return rt->fallback(47);
+L49:
+  rt->count(49);
+  if (!rt->indirect_store(50)) return rt->fallback(49);
+L50:
+  rt->count(50);
+  if (!rt->check_stack_length(3)) return rt->fallback(50);
+L52:
+  rt->count(52);
+  goto L60;
+L54:
+  rt->count(54);
+  rt->push(0);
+L55:
+  rt->count(55);
+  if (!rt->load_fp_rel(1)) return rt->fallback(55);
+L57:
+  rt->count(57);
+  if (!rt->indirect_store(58)) return rt->fallback(57);
+L58:
+  rt->count(58);
+  if (!rt->check_stack_length(3)) return rt->fallback(58);
+L60:
+  rt->count(60);
+  if (!rt->load_fp_rel(0)) return rt->fallback(60);
+L62:
+  rt->count(62);
+  if (!rt->indirect_load(63)) return rt->fallback(62);
+L63:
+  rt->count(63);
+  if (!rt->bool_not()) return rt->fallback(63);
+L64:
+  rt->count(64);
+  if (!rt->bool_project()) return rt->fallback(64);
+L65:
+  rt->count(65);
+  if (!rt->load_fp_rel(0)) return rt->fallback(65);
+L67:
+  rt->count(67);
+  if (!rt->indirect_store(68)) return rt->fallback(67);
+L68:
+  rt->count(68);
+  return rt->terminate(68);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block3
+
+namespace block4 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\011\020\003led\021\000\177\000\002\002\026\012"
+    "\000\013&'\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 8: goto L8;
+    case 11: goto L11;
+    case 12: goto L12;
+    case 13: goto L13;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 17: goto L17;
+    case 18: goto L18;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L12;
+L3:
+  rt->count(3);
+  rt->load_string("led", 3);
+L8:
+  rt->count(8);
+  if (!rt->create_var(0, -1, 11)) return rt->fallback(8);
+L11:
+  rt->count(11);
+  return rt->terminate(12);
+L12:
+  rt->count(12);
+  rt->push(0);
+L13:
+  rt->count(13);
+  rt->push(0);
+L14:
+  rt->count(14);
+  if (!rt->import_var()) return rt->fallback(14);
+L15:
+  rt->count(15);
+  if (!rt->load_fp_rel(0)) return rt->fallback(15);
+L17:
+  rt->count(17);
+  if (!rt->indirect_load(18)) return rt->fallback(17);
+L18:
+  rt->count(18);
+  if (!rt->bool_not()) return rt->fallback(18);
+L19:
+  rt->count(19);
+  if (!rt->bool_project()) return rt->fallback(19);
+L20:
+  rt->count(20);
+  if (!rt->load_fp_rel(0)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->indirect_store(23)) return rt->fallback(22);
+L23:
+  rt->count(23);
+  return rt->terminate(23);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block4
+
+namespace block5 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\014\020\006signal\021\000\004\000\002"
+    "\002\026\012\000\013\003\030\001\004\034\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 11: goto L11;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 16: goto L16;
+    case 17: goto L17;
+    case 18: goto L18;
+    case 20: goto L20;
+    case 21: goto L21;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 26: goto L26;
+    case 28: goto L28;
+    case 29: goto L29;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L15;
+L3:
+  rt->count(3);
+  rt->load_string("signal", 6);
+L11:
+  rt->count(11);
+  if (!rt->create_var(0, 4, 14)) return rt->fallback(11);
+L14:
+  rt->count(14);
+  return rt->terminate(15);
+L15:
+  rt->count(15);
+  rt->push(0);
+L16:
+  rt->count(16);
+  rt->push(0);
+L17:
+  rt->count(17);
+  if (!rt->import_var()) return rt->fallback(17);
+L18:
+  rt->count(18);
+  if (!rt->load_fp_rel(0)) return rt->fallback(18);
+L20:
+  rt->count(20);
+  if (!rt->indirect_load(21)) return rt->fallback(20);
+L21:
+  rt->count(21);
+  rt->push(1);
+L22:
+  rt->count(22);
+  if (!rt->numeric_plus()) return rt->fallback(22);
+L23:
+  rt->count(23);
+  rt->push(4);
+L25:
+  rt->count(25);
+  if (!rt->numeric_mod()) return rt->fallback(25);
+L26:
+  rt->count(26);
+  if (!rt->load_fp_rel(0)) return rt->fallback(26);
+L28:
+  rt->count(28);
+  if (!rt->indirect_store(29)) return rt->fallback(28);
+L29:
+  rt->count(29);
+  return rt->terminate(29);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block5
+
+namespace block6 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\006\000\001\273\001.+\010\000\002\001\004*\000"
+    "\005\001\210\007.\010\000\002\001\004*\000\005";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 7: goto L7;
+    case 8: goto L8;
+    case 9: goto L9;
+    case 11: goto L11;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 16: goto L16;
+    case 17: goto L17;
+    case 20: goto L20;
+    case 21: goto L21;
+    case 23: goto L23;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 28: goto L28;
+    case 29: goto L29;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L9;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  rt->push(123);
+L7:
+  rt->count(7);
+  if (!rt->print_num()) return rt->fallback(7);
+L8:
+  rt->count(8);
+  if (!rt->ret(9, &jumped)) return rt->fallback(8);
+  if (jumped) goto transfer;
+L9:
+  rt->count(9);
+  if (!rt->check_stack_length(0)) return rt->fallback(9);
+L11:
+  rt->count(11);
+  rt->push(0);
+L12:
+  rt->count(12);
+  rt->push(4);
+L14:
+  rt->count(14);
+  if (!rt->call(0, 16, &jumped)) return rt->fallback(14);
+  if (jumped) goto transfer;
+L16:
+  rt->count(16);
+  if (!rt->pop_op()) return rt->fallback(16);
+L17:
+  rt->count(17);
+  rt->push(456);
+L20:
+  rt->count(20);
+  if (!rt->print_num()) return rt->fallback(20);
+L21:
+  rt->count(21);
+  if (!rt->check_stack_length(0)) return rt->fallback(21);
+L23:
+  rt->count(23);
+  rt->push(0);
+L24:
+  rt->count(24);
+  rt->push(4);
+L26:
+  rt->count(26);
+  if (!rt->call(0, 28, &jumped)) return rt->fallback(26);
+  if (jumped) goto transfer;
+L28:
+  rt->count(28);
+  if (!rt->pop_op()) return rt->fallback(28);
+L29:
+  rt->count(29);
+  return rt->terminate(29);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block6
+
+namespace block7 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001\027)\005\001\013\011\177+\010"
+    "\001\002\001\012*\000\011\000\012\000.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 17: goto L17;
+    case 18: goto L18;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 27: goto L27;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(23);
+L8:
+  rt->count(8);
+  goto L15;
+L10:
+  rt->count(10);
+  rt->push(11);
+L12:
+  rt->count(12);
+  if (!rt->store_fp_rel(-1)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  if (!rt->ret(15, &jumped)) return rt->fallback(14);
+  if (jumped) goto transfer;
+L15:
+  rt->count(15);
+  if (!rt->check_stack_length(1)) return rt->fallback(15);
+L17:
+  rt->count(17);
+  rt->push(0);
+L18:
+  rt->count(18);
+  rt->push(10);
+L20:
+  rt->count(20);
+  if (!rt->call(0, 22, &jumped)) return rt->fallback(20);
+  if (jumped) goto transfer;
+L22:
+  rt->count(22);
+  if (!rt->store_fp_rel(0)) return rt->fallback(22);
+L24:
+  rt->count(24);
+  if (!rt->load_fp_rel(0)) return rt->fallback(24);
+L26:
+  rt->count(26);
+  if (!rt->print_num()) return rt->fallback(26);
+L27:
+  rt->count(27);
+  return rt->terminate(27);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block7
+
+namespace block8 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001 )\021\001\215\001.+\012"
+    "\000.\010\001\002\001\012*\000\005+\010\001\002\012\000"
+    "\001\017*\001\005\010\001\001,\012\000.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 13: goto L13;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 17: goto L17;
+    case 18: goto L18;
+    case 20: goto L20;
+    case 21: goto L21;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 26: goto L26;
+    case 27: goto L27;
+    case 29: goto L29;
+    case 30: goto L30;
+    case 32: goto L32;
+    case 34: goto L34;
+    case 36: goto L36;
+    case 37: goto L37;
+    case 39: goto L39;
+    case 41: goto L41;
+    case 43: goto L43;
+    case 44: goto L44;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(32);
+L8:
+  rt->count(8);
+  goto L27;
+L10:
+  rt->count(10);
+  rt->push(77);
+L13:
+  rt->count(13);
+  if (!rt->print_num()) return rt->fallback(13);
+L14:
+  rt->count(14);
+  if (!rt->ret(15, &jumped)) return rt->fallback(14);
+  if (jumped) goto transfer;
+L15:
+  rt->count(15);
+  if (!rt->load_fp_rel(0)) return rt->fallback(15);
+L17:
+  rt->count(17);
+  if (!rt->print_num()) return rt->fallback(17);
+L18:
+  rt->count(18);
+  if (!rt->check_stack_length(1)) return rt->fallback(18);
+L20:
+  rt->count(20);
+  rt->push(0);
+L21:
+  rt->count(21);
+  rt->push(10);
+L23:
+  rt->count(23);
+  if (!rt->call(0, 25, &jumped)) return rt->fallback(23);
+  if (jumped) goto transfer;
+L25:
+  rt->count(25);
+  if (!rt->pop_op()) return rt->fallback(25);
+L26:
+  rt->count(26);
+  if (!rt->ret(27, &jumped)) return rt->fallback(26);
+  if (jumped) goto transfer;
+L27:
+  rt->count(27);
+  if (!rt->check_stack_length(1)) return rt->fallback(27);
+L29:
+  rt->count(29);
+  rt->push(0);
+L30:
+  rt->count(30);
+  if (!rt->load_fp_rel(0)) return rt->fallback(30);
+L32:
+  rt->count(32);
+  rt->push(15);
+L34:
+  rt->count(34);
+  if (!rt->call(1, 36, &jumped)) return rt->fallback(34);
+  if (jumped) goto transfer;
+L36:
+  rt->count(36);
+  if (!rt->pop_op()) return rt->fallback(36);
+L37:
+  rt->count(37);
+  if (!rt->check_stack_length(1)) return rt->fallback(37);
+L39:
+  rt->count(39);
+  rt->push(44);
+L41:
+  rt->count(41);
+  if (!rt->load_fp_rel(0)) return rt->fallback(41);
+L43:
+  rt->count(43);
+  if (!rt->print_num()) return rt->fallback(43);
+L44:
+  rt->count(44);
+  return rt->terminate(44);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block8
+
+namespace block9 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001 )\034\012\000\013.\001\021"
+    "\012\000\014+\010\000\001\005\010\001\002\027\000\001\012*"
+    "\001\005\012\000.+\010\001\002\001\024*\000\005\012\000"
+    ".";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 13: goto L13;
+    case 14: goto L14;
+    case 16: goto L16;
+    case 18: goto L18;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 27: goto L27;
+    case 29: goto L29;
+    case 31: goto L31;
+    case 33: goto L33;
+    case 34: goto L34;
+    case 36: goto L36;
+    case 37: goto L37;
+    case 38: goto L38;
+    case 40: goto L40;
+    case 41: goto L41;
+    case 43: goto L43;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 48: goto L48;
+    case 49: goto L49;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(32);
+L8:
+  rt->count(8);
+  goto L38;
+L10:
+  rt->count(10);
+  if (!rt->load_fp_rel(0)) return rt->fallback(10);
+L12:
+  rt->count(12);
+  if (!rt->indirect_load(13)) return rt->fallback(12);
+L13:
+  rt->count(13);
+  if (!rt->print_num()) return rt->fallback(13);
+L14:
+  rt->count(14);
+  rt->push(17);
+L16:
+  rt->count(16);
+  if (!rt->load_fp_rel(0)) return rt->fallback(16);
+L18:
+  rt->count(18);
+  if (!rt->indirect_store(19)) return rt->fallback(18);
+L19:
+  rt->count(19);
+  if (!rt->ret(20, &jumped)) return rt->fallback(19);
+  if (jumped) goto transfer;
+L20:
+  rt->count(20);
+  if (!rt->check_stack_length(0)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  rt->push(5);
+L24:
+  rt->count(24);
+  if (!rt->check_stack_length(1)) return rt->fallback(24);
+L26:
+  rt->count(26);
+  rt->push(0);
+L27:
+  rt->count(27);
+  rt->create_indirect_var(0);
+L29:
+  rt->count(29);
+  rt->push(10);
+L31:
+  rt->count(31);
+  if (!rt->call(1, 33, &jumped)) return rt->fallback(31);
+  if (jumped) goto transfer;
+L33:
+  rt->count(33);
+  if (!rt->pop_op()) return rt->fallback(33);
+L34:
+  rt->count(34);
+  if (!rt->load_fp_rel(0)) return rt->fallback(34);
+L36:
+  rt->count(36);
+  if (!rt->print_num()) return rt->fallback(36);
+L37:
+  rt->count(37);
+  if (!rt->ret(38, &jumped)) return rt->fallback(37);
+  if (jumped) goto transfer;
+L38:
+  rt->count(38);
+  if (!rt->check_stack_length(1)) return rt->fallback(38);
+L40:
+  rt->count(40);
+  rt->push(0);
+L41:
+  rt->count(41);
+  rt->push(20);
+L43:
+  rt->count(43);
+  if (!rt->call(0, 45, &jumped)) return rt->fallback(43);
+  if (jumped) goto transfer;
+L45:
+  rt->count(45);
+  if (!rt->pop_op()) return rt->fallback(45);
+L46:
+  rt->count(46);
+  if (!rt->load_fp_rel(0)) return rt->fallback(46);
+L48:
+  rt->count(48);
+  if (!rt->print_num()) return rt->fallback(48);
+L49:
+  rt->count(49);
+  return rt->terminate(49);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block9
+
+namespace block10 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\030\020\003foo\021\000\177\020\003bar"
+    "\021\001\177\000\012\001'\012\000\014+\002\002\026\003\002"
+    "\026\010\002\002\012\001\012\000\013\001\024*\002\005\012\000"
+    "\013&'\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 8: goto L8;
+    case 11: goto L11;
+    case 16: goto L16;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 26: goto L26;
+    case 27: goto L27;
+    case 28: goto L28;
+    case 29: goto L29;
+    case 30: goto L30;
+    case 31: goto L31;
+    case 32: goto L32;
+    case 33: goto L33;
+    case 35: goto L35;
+    case 36: goto L36;
+    case 38: goto L38;
+    case 40: goto L40;
+    case 41: goto L41;
+    case 43: goto L43;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 48: goto L48;
+    case 49: goto L49;
+    case 50: goto L50;
+    case 51: goto L51;
+    case 53: goto L53;
+    case 54: goto L54;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L27;
+L3:
+  rt->count(3);
+  rt->load_string("foo", 3);
+L8:
+  rt->count(8);
+  if (!rt->create_var(0, -1, 11)) return rt->fallback(8);
+L11:
+  rt->count(11);
+  rt->load_string("bar", 3);
+L16:
+  rt->count(16);
+  if (!rt->create_var(1, -1, 19)) return rt->fallback(16);
+L19:
+  rt->count(19);
+  return rt->terminate(20);
+L20:
+  rt->count(20);
+  if (!rt->load_fp_rel(1)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->bool_project()) return rt->fallback(22);
+L23:
+  rt->count(23);
+  if (!rt->load_fp_rel(0)) return rt->fallback(23);
+L25:
+  rt->count(25);
+  if (!rt->indirect_store(26)) return rt->fallback(25);
+L26:
+  rt->count(26);
+  if (!rt->ret(27, &jumped)) return rt->fallback(26);
+  if (jumped) goto transfer;
+L27:
+  rt->count(27);
+  rt->push(0);
+L28:
+  rt->count(28);
+  rt->push(0);
+L29:
+  rt->count(29);
+  if (!rt->import_var()) return rt->fallback(29);
+L30:
+  rt->count(30);
+  rt->push(1);
+L31:
+  rt->count(31);
+  rt->push(0);
+L32:
+  rt->count(32);
+  if (!rt->import_var()) return rt->fallback(32);
+L33:
+  rt->count(33);
+  if (!rt->check_stack_length(2)) return rt->fallback(33);
+L35:
+  rt->count(35);
+  rt->push(0);
+L36:
+  rt->count(36);
+  if (!rt->load_fp_rel(1)) return rt->fallback(36);
+L38:
+  rt->count(38);
+  if (!rt->load_fp_rel(0)) return rt->fallback(38);
+L40:
+  rt->count(40);
+  if (!rt->indirect_load(41)) return rt->fallback(40);
+L41:
+  rt->count(41);
+  rt->push(20);
+L43:
+  rt->count(43);
+  if (!rt->call(2, 45, &jumped)) return rt->fallback(43);
+  if (jumped) goto transfer;
+L45:
+  rt->count(45);
+  if (!rt->pop_op()) return rt->fallback(45);
+L46:
+  rt->count(46);
+  if (!rt->load_fp_rel(0)) return rt->fallback(46);
+L48:
+  rt->count(48);
+  if (!rt->indirect_load(49)) return rt->fallback(48);
+L49:
+  rt->count(49);
+  if (!rt->bool_not()) return rt->fallback(49);
+L50:
+  rt->count(50);
+  if (!rt->bool_project()) return rt->fallback(50);
+L51:
+  rt->count(51);
+  if (!rt->load_fp_rel(0)) return rt->fallback(51);
+L53:
+  rt->count(53);
+  if (!rt->indirect_store(54)) return rt->fallback(53);
+L54:
+  rt->count(54);
+  return rt->terminate(54);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block10
+
+namespace block11 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\031\020\003foo\021\000\177\020\003bar"
+    "\021\001\177\000\012\001\013'\012\000\014+\002\002\026\003"
+    "\002\026\010\002\002\012\001\012\000\001\024*\002\005\012\000"
+    "\013&'\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 8: goto L8;
+    case 11: goto L11;
+    case 16: goto L16;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 27: goto L27;
+    case 28: goto L28;
+    case 29: goto L29;
+    case 30: goto L30;
+    case 31: goto L31;
+    case 32: goto L32;
+    case 33: goto L33;
+    case 34: goto L34;
+    case 36: goto L36;
+    case 37: goto L37;
+    case 39: goto L39;
+    case 41: goto L41;
+    case 43: goto L43;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 48: goto L48;
+    case 49: goto L49;
+    case 50: goto L50;
+    case 51: goto L51;
+    case 53: goto L53;
+    case 54: goto L54;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L28;
+L3:
+  rt->count(3);
+  rt->load_string("foo", 3);
+L8:
+  rt->count(8);
+  if (!rt->create_var(0, -1, 11)) return rt->fallback(8);
+L11:
+  rt->count(11);
+  rt->load_string("bar", 3);
+L16:
+  rt->count(16);
+  if (!rt->create_var(1, -1, 19)) return rt->fallback(16);
+L19:
+  rt->count(19);
+  return rt->terminate(20);
+L20:
+  rt->count(20);
+  if (!rt->load_fp_rel(1)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->indirect_load(23)) return rt->fallback(22);
+L23:
+  rt->count(23);
+  if (!rt->bool_project()) return rt->fallback(23);
+L24:
+  rt->count(24);
+  if (!rt->load_fp_rel(0)) return rt->fallback(24);
+L26:
+  rt->count(26);
+  if (!rt->indirect_store(27)) return rt->fallback(26);
+L27:
+  rt->count(27);
+  if (!rt->ret(28, &jumped)) return rt->fallback(27);
+  if (jumped) goto transfer;
+L28:
+  rt->count(28);
+  rt->push(0);
+L29:
+  rt->count(29);
+  rt->push(0);
+L30:
+  rt->count(30);
+  if (!rt->import_var()) return rt->fallback(30);
+L31:
+  rt->count(31);
+  rt->push(1);
+L32:
+  rt->count(32);
+  rt->push(0);
+L33:
+  rt->count(33);
+  if (!rt->import_var()) return rt->fallback(33);
+L34:
+  rt->count(34);
+  if (!rt->check_stack_length(2)) return rt->fallback(34);
+L36:
+  rt->count(36);
+  rt->push(0);
+L37:
+  rt->count(37);
+  if (!rt->load_fp_rel(1)) return rt->fallback(37);
+L39:
+  rt->count(39);
+  if (!rt->load_fp_rel(0)) return rt->fallback(39);
+L41:
+  rt->count(41);
+  rt->push(20);
+L43:
+  rt->count(43);
+  if (!rt->call(2, 45, &jumped)) return rt->fallback(43);
+  if (jumped) goto transfer;
+L45:
+  rt->count(45);
+  if (!rt->pop_op()) return rt->fallback(45);
+L46:
+  rt->count(46);
+  if (!rt->load_fp_rel(0)) return rt->fallback(46);
+L48:
+  rt->count(48);
+  if (!rt->indirect_load(49)) return rt->fallback(48);
+L49:
+  rt->count(49);
+  if (!rt->bool_not()) return rt->fallback(49);
+L50:
+  rt->count(50);
+  if (!rt->bool_project()) return rt->fallback(50);
+L51:
+  rt->count(51);
+  if (!rt->load_fp_rel(0)) return rt->fallback(51);
+L53:
+  rt->count(53);
+  if (!rt->indirect_store(54)) return rt->fallback(53);
+L54:
+  rt->count(54);
+  return rt->terminate(54);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block11
+
+namespace block12 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,&\020\003foo\021\000\177\020\003bar"
+    "\021\001\177\000\012\001\013'\012\000\014+\010\002\002\012"
+    "\000\027\001\001\024*\002\005+\002\002\026\003\002\026\010"
+    "\002\002\012\001\012\000\013\001\034*\002\005\012\000\013&"
+    "'\012\000\014";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 8: goto L8;
+    case 11: goto L11;
+    case 16: goto L16;
+    case 19: goto L19;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 27: goto L27;
+    case 28: goto L28;
+    case 30: goto L30;
+    case 31: goto L31;
+    case 33: goto L33;
+    case 35: goto L35;
+    case 37: goto L37;
+    case 39: goto L39;
+    case 40: goto L40;
+    case 41: goto L41;
+    case 42: goto L42;
+    case 43: goto L43;
+    case 44: goto L44;
+    case 45: goto L45;
+    case 46: goto L46;
+    case 47: goto L47;
+    case 49: goto L49;
+    case 50: goto L50;
+    case 52: goto L52;
+    case 54: goto L54;
+    case 55: goto L55;
+    case 57: goto L57;
+    case 59: goto L59;
+    case 60: goto L60;
+    case 62: goto L62;
+    case 63: goto L63;
+    case 64: goto L64;
+    case 65: goto L65;
+    case 67: goto L67;
+    case 68: goto L68;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L41;
+L3:
+  rt->count(3);
+  rt->load_string("foo", 3);
+L8:
+  rt->count(8);
+  if (!rt->create_var(0, -1, 11)) return rt->fallback(8);
+L11:
+  rt->count(11);
+  rt->load_string("bar", 3);
+L16:
+  rt->count(16);
+  if (!rt->create_var(1, -1, 19)) return rt->fallback(16);
+L19:
+  rt->count(19);
+  return rt->terminate(20);
+L20:
+  rt->count(20);
+  if (!rt->load_fp_rel(1)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->indirect_load(23)) return rt->fallback(22);
+L23:
+  rt->count(23);
+  if (!rt->bool_project()) return rt->fallback(23);
+L24:
+  rt->count(24);
+  if (!rt->load_fp_rel(0)) return rt->fallback(24);
+L26:
+  rt->count(26);
+  if (!rt->indirect_store(27)) return rt->fallback(26);
+L27:
+  rt->count(27);
+  if (!rt->ret(28, &jumped)) return rt->fallback(27);
+  if (jumped) goto transfer;
+L28:
+  rt->count(28);
+  if (!rt->check_stack_length(2)) return rt->fallback(28);
+L30:
+  rt->count(30);
+  rt->push(0);
+L31:
+  rt->count(31);
+  if (!rt->load_fp_rel(0)) return rt->fallback(31);
+L33:
+  rt->count(33);
+  rt->create_indirect_var(1);
+L35:
+  rt->count(35);
+  rt->push(20);
+L37:
+  rt->count(37);
+  if (!rt->call(2, 39, &jumped)) return rt->fallback(37);
+  if (jumped) goto transfer;
+L39:
+  rt->count(39);
+  if (!rt->pop_op()) return rt->fallback(39);
+L40:
+  rt->count(40);
+  if (!rt->ret(41, &jumped)) return rt->fallback(40);
+  if (jumped) goto transfer;
+L41:
+  rt->count(41);
+  rt->push(0);
+L42:
+  rt->count(42);
+  rt->push(0);
+L43:
+  rt->count(43);
+  if (!rt->import_var()) return rt->fallback(43);
+L44:
+  rt->count(44);
+  rt->push(1);
+L45:
+  rt->count(45);
+  rt->push(0);
+L46:
+  rt->count(46);
+  if (!rt->import_var()) return rt->fallback(46);
+L47:
+  rt->count(47);
+  if (!rt->check_stack_length(2)) return rt->fallback(47);
+L49:
+  rt->count(49);
+  rt->push(0);
+L50:
+  rt->count(50);
+  if (!rt->load_fp_rel(1)) return rt->fallback(50);
+L52:
+  rt->count(52);
+  if (!rt->load_fp_rel(0)) return rt->fallback(52);
+L54:
+  rt->count(54);
+  if (!rt->indirect_load(55)) return rt->fallback(54);
+L55:
+  rt->count(55);
+  rt->push(28);
+L57:
+  rt->count(57);
+  if (!rt->call(2, 59, &jumped)) return rt->fallback(57);
+  if (jumped) goto transfer;
+L59:
+  rt->count(59);
+  if (!rt->pop_op()) return rt->fallback(59);
+L60:
+  rt->count(60);
+  if (!rt->load_fp_rel(0)) return rt->fallback(60);
+L62:
+  rt->count(62);
+  if (!rt->indirect_load(63)) return rt->fallback(62);
+L63:
+  rt->count(63);
+  if (!rt->bool_not()) return rt->fallback(63);
+L64:
+  rt->count(64);
+  if (!rt->bool_project()) return rt->fallback(64);
+L65:
+  rt->count(65);
+  if (!rt->load_fp_rel(0)) return rt->fallback(65);
+L67:
+  rt->count(67);
+  if (!rt->indirect_store(68)) return rt->fallback(67);
+L68:
+  rt->count(68);
+  return rt->terminate(68);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block12
+
+namespace block13 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\022\000,\004\001 \024\000\010\000\023\000"
+    "\003\030\012\000\024\000\023\000.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 16: goto L16;
+    case 17: goto L17;
+    case 18: goto L18;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 24: goto L24;
+    case 25: goto L25;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->init_static(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  if (!rt->pop(&value)) return rt->fallback(6);
+  if (value == 0) goto L12;
+L8:
+  rt->count(8);
+  rt->push(32);
+L10:
+  rt->count(10);
+  if (!rt->store_static(0)) return rt->fallback(10);
+L12:
+  rt->count(12);
+  if (!rt->check_stack_length(0)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  if (!rt->load_static(0)) return rt->fallback(14);
+L16:
+  rt->count(16);
+  rt->push(1);
+L17:
+  rt->count(17);
+  if (!rt->numeric_plus()) return rt->fallback(17);
+L18:
+  rt->count(18);
+  if (!rt->load_fp_rel(0)) return rt->fallback(18);
+L20:
+  rt->count(20);
+  if (!rt->store_static(0)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->load_static(0)) return rt->fallback(22);
+L24:
+  rt->count(24);
+  if (!rt->print_num()) return rt->fallback(24);
+L25:
+  rt->count(25);
+  return rt->terminate(25);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block13
+
+namespace block14 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\012\000\012\000\013\003\030\012\000\014+\022\000,"
+    "\004\001\005\024\000\010\000\002\025\000\001\004*\001\005\023"
+    "\000.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 7: goto L7;
+    case 8: goto L8;
+    case 9: goto L9;
+    case 11: goto L11;
+    case 12: goto L12;
+    case 13: goto L13;
+    case 15: goto L15;
+    case 17: goto L17;
+    case 19: goto L19;
+    case 21: goto L21;
+    case 23: goto L23;
+    case 24: goto L24;
+    case 26: goto L26;
+    case 28: goto L28;
+    case 30: goto L30;
+    case 31: goto L31;
+    case 33: goto L33;
+    case 34: goto L34;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L13;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->load_fp_rel(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  if (!rt->indirect_load(7)) return rt->fallback(6);
+L7:
+  rt->count(7);
+  rt->push(1);
+L8:
+  rt->count(8);
+  if (!rt->numeric_plus()) return rt->fallback(8);
+L9:
+  rt->count(9);
+  if (!rt->load_fp_rel(0)) return rt->fallback(9);
+L11:
+  rt->count(11);
+  if (!rt->indirect_store(12)) return rt->fallback(11);
+L12:
+  rt->count(12);
+  if (!rt->ret(13, &jumped)) return rt->fallback(12);
+  if (jumped) goto transfer;
+L13:
+  rt->count(13);
+  if (!rt->init_static(0)) return rt->fallback(13);
+L15:
+  rt->count(15);
+  if (!rt->pop(&value)) return rt->fallback(15);
+  if (value == 0) goto L21;
+L17:
+  rt->count(17);
+  rt->push(5);
+L19:
+  rt->count(19);
+  if (!rt->store_static(0)) return rt->fallback(19);
+L21:
+  rt->count(21);
+  if (!rt->check_stack_length(0)) return rt->fallback(21);
+L23:
+  rt->count(23);
+  rt->push(0);
+L24:
+  rt->count(24);
+  rt->create_indirect_static(0);
+L26:
+  rt->count(26);
+  rt->push(4);
+L28:
+  rt->count(28);
+  if (!rt->call(1, 30, &jumped)) return rt->fallback(28);
+  if (jumped) goto transfer;
+L30:
+  rt->count(30);
+  if (!rt->pop_op()) return rt->fallback(30);
+L31:
+  rt->count(31);
+  if (!rt->load_static(0)) return rt->fallback(31);
+L33:
+  rt->count(33);
+  if (!rt->print_num()) return rt->fallback(33);
+L34:
+  rt->count(34);
+  return rt->terminate(34);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block14
+
+namespace block15 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\010\000\001\027\012\000\003\030\011\000\000";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 11: goto L11;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 15: goto L15;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->check_stack_length(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  rt->push(23);
+L8:
+  rt->count(8);
+  if (!rt->load_fp_rel(0)) return rt->fallback(8);
+L10:
+  rt->count(10);
+  rt->push(1);
+L11:
+  rt->count(11);
+  if (!rt->numeric_plus()) return rt->fallback(11);
+L12:
+  rt->count(12);
+  if (!rt->store_fp_rel(0)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  return rt->terminate(15);
+L15:
+  rt->count(15);
+  return rt->terminate(15);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block15
+
+namespace block16 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\001\000\022\000,\004\001\002\024\000\023\000\003\031"
+    "\024\000\001\012\023\000\033.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  int value;
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 10: goto L10;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 15: goto L15;
+    case 16: goto L16;
+    case 18: goto L18;
+    case 20: goto L20;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 24: goto L24;
+    default: return rt->interpret(ofs);
+  }
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L4;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  if (!rt->init_static(0)) return rt->fallback(4);
+L6:
+  rt->count(6);
+  if (!rt->pop(&value)) return rt->fallback(6);
+  if (value == 0) goto L12;
+L8:
+  rt->count(8);
+  rt->push(2);
+L10:
+  rt->count(10);
+  if (!rt->store_static(0)) return rt->fallback(10);
+L12:
+  rt->count(12);
+  if (!rt->load_static(0)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  rt->push(1);
+L15:
+  rt->count(15);
+  if (!rt->numeric_minus()) return rt->fallback(15);
+L16:
+  rt->count(16);
+  if (!rt->store_static(0)) return rt->fallback(16);
+L18:
+  rt->count(18);
+  rt->push(10);
+L20:
+  rt->count(20);
+  if (!rt->load_static(0)) return rt->fallback(20);
+L22:
+  rt->count(22);
+  if (!rt->numeric_div()) return rt->fallback(22);
+L23:
+  rt->count(23);
+  if (!rt->print_num()) return rt->fallback(23);
+L24:
+  rt->count(24);
+  return rt->terminate(24);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block16
+
+namespace block17 {
+
+// Generated by logic2cxx. Do not edit.
+
+#include "logic/NativeRuntime.hxx"
+
+namespace {
+
+/// Bytecode this code was translated from.
+const char bytecode[] =
+    "(,\011\000\001\012\012\000\033\011\177+\022\000,\003"
+    "\003\024\000\023\000\003\031\024\000\010\000\002\023\000\001\004"
+    "*\001.";
+
+bool run(logic::NativeRuntime* rt, unsigned ofs) {
+  bool jumped;
+  int value;
+dispatch:
+  switch (ofs) {
+    case 0: goto L0;
+    case 1: goto L1;
+    case 3: goto L3;
+    case 4: goto L4;
+    case 6: goto L6;
+    case 8: goto L8;
+    case 9: goto L9;
+    case 11: goto L11;
+    case 12: goto L12;
+    case 14: goto L14;
+    case 16: goto L16;
+    case 17: goto L17;
+    case 19: goto L19;
+    case 21: goto L21;
+    case 22: goto L22;
+    case 23: goto L23;
+    case 25: goto L25;
+    case 27: goto L27;
+    case 28: goto L28;
+    case 30: goto L30;
+    case 32: goto L32;
+    case 34: goto L34;
+    case 35: goto L35;
+    default: return rt->interpret(ofs);
+  }
+transfer:
+  if (!rt->resume(&ofs)) return rt->interpret();
+  goto dispatch;
+L0:
+  rt->count(0);
+  rt->if_preamble();
+L1:
+  rt->count(1);
+  if (!rt->pop(&value)) return rt->fallback(1);
+  if (value == 0) goto L12;
+L3:
+  rt->count(3);
+  return rt->terminate(4);
+L4:
+  rt->count(4);
+  rt->push(10);
+L6:
+  rt->count(6);
+  if (!rt->load_fp_rel(0)) return rt->fallback(6);
+L8:
+  rt->count(8);
+  if (!rt->numeric_div()) return rt->fallback(8);
+L9:
+  rt->count(9);
+  if (!rt->store_fp_rel(-1)) return rt->fallback(9);
+L11:
+  rt->count(11);
+  if (!rt->ret(12, &jumped)) return rt->fallback(11);
+  if (jumped) goto transfer;
+L12:
+  rt->count(12);
+  if (!rt->init_static(0)) return rt->fallback(12);
+L14:
+  rt->count(14);
+  if (!rt->pop(&value)) return rt->fallback(14);
+  if (value == 0) goto L19;
+L16:
+  rt->count(16);
+  rt->push(1);
+L17:
+  rt->count(17);
+  if (!rt->store_static(0)) return rt->fallback(17);
+L19:
+  rt->count(19);
+  if (!rt->load_static(0)) return rt->fallback(19);
+L21:
+  rt->count(21);
+  rt->push(1);
+L22:
+  rt->count(22);
+  if (!rt->numeric_minus()) return rt->fallback(22);
+L23:
+  rt->count(23);
+  if (!rt->store_static(0)) return rt->fallback(23);
+L25:
+  rt->count(25);
+  if (!rt->check_stack_length(0)) return rt->fallback(25);
+L27:
+  rt->count(27);
+  rt->push(0);
+L28:
+  rt->count(28);
+  if (!rt->load_static(0)) return rt->fallback(28);
+L30:
+  rt->count(30);
+  rt->push(4);
+L32:
+  rt->count(32);
+  if (!rt->call(1, 34, &jumped)) return rt->fallback(32);
+  if (jumped) goto transfer;
+L34:
+  rt->count(34);
+  if (!rt->print_num()) return rt->fallback(34);
+L35:
+  rt->count(35);
+  return rt->terminate(35);
+}
+
+logic::NativeBlock block = {bytecode, sizeof(bytecode) - 1, &run, nullptr};
+logic::NativeBlockRegistration registration(&block);
+
+} // namespace
+
+} // namespace block17
+
+/// Hash of the translator output of each block.
+const uint32_t text_hashes[] = {
+    0x079a8118,
+    0x194ca7d4,
+    0xf1227e6a,
+    0xc12d58a0,
+    0x717bf806,
+    0xb6806b45,
+    0x822b7cfd,
+    0xe69176c5,
+    0xec465c98,
+    0xf5178d2a,
+    0xd05d253a,
+    0xa0da9cf0,
+    0x17c17ddc,
+    0x2e63d5a1,
+    0x95ae9425,
+    0x5ce17659,
+    0x06d85f54,
+    0x59217e7a,
+};
+
+} // namespace translated
+
+#endif // _LOGIC_CXXTRANSLATORTESTBLOCKS_HXX_
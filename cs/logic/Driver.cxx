@@ -33,6 +33,7 @@
  */
 
 #include "logic/Driver.hxx"
+#include "logic/Optimizer.hxx"
 #include "logic/Parser.hxxout"
 
 namespace logic {
@@ -47,8 +48,22 @@ int Driver::parse_file(const std::string& f) {
   return res;
 }
 
+int Driver::parse_buffer(const char* buf, size_t len) {
+  filename_ = "<source>";
+  source_buf_ = buf;
+  source_len_ = len;
+  scan_begin();
+  int res = parser.parse();
+  scan_end();
+  source_buf_ = nullptr;
+  source_len_ = 0;
+  if (!error_output_.empty()) return 1;
+  return res;
+}
+
 void Driver::serialize(std::string* output) {
   output_root_ = output;
+  size_t start = output->size();
   string preamble;
   // Renders preamble.
   for (const auto& c : commands_) {
@@ -73,6 +88,24 @@ void Driver::serialize(std::string* output) {
   for (const auto& c : commands_) {
     c->serialize(output);
   }
+
+  unoptimized_size_ = output->size() - start;
+  source_lines_.clear();
+  SourceLineTable* lines = line_info_ ? &source_lines_ : nullptr;
+  bool optimized = false;
+  if (optimize_) {
+    std::string code = output->substr(start);
+    if (BytecodeOptimizer::optimize(&code, start, lines)) {
+      output->resize(start);
+      output->append(code);
+      optimized = true;
+    }
+  }
+  if (lines && !optimized) {
+    // The SOURCE_LINE instructions stay in the code.
+    BytecodeOptimizer::collect_source_lines(output->substr(start), start,
+                                            lines);
+  }
 }
 
 void Driver::error(const yy::location& l, const std::string& m) {
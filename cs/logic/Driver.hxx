@@ -56,6 +56,11 @@ namespace logic {
 // Encapsulation of the scanning and parsing process.
 class Driver {
  public:
+  /// Version of the code generation. Has to be incremented whenever the
+  /// bytecode rendered for the same source changes, because the compiled
+  /// bytecode is cached across restarts.
+  static constexpr uint32_t COMPILER_VERSION = 3;
+
   /// Constructor.
   Driver() {}
 
@@ -65,6 +70,7 @@ class Driver {
     current_context_ = &global_context_;
     commands_.clear();
     error_output_.clear();
+    next_static_slot_ = 0;
     //next_guid_ = 1;
   }
 
@@ -266,7 +272,15 @@ class Driver {
   std::shared_ptr<Command> declare_variable(
       string name, const yy::location& loc,
       PolymorphicExpression* initial_value, const yy::location& val_loc) {
-    Symbol* s = allocate_variable(name, loc, Symbol::VARIABLE);
+    Symbol* s;
+    if (decl_storage_ == Symbol::STATIC_VAR) {
+      // Static variables live in the static variable array of the block
+      // instead of the operand stack.
+      s = allocate_symbol(name, loc, Symbol::VARIABLE);
+      if (s) s->static_slot_ = next_static_slot_++;
+    } else {
+      s = allocate_variable(name, loc, Symbol::VARIABLE);
+    }
     if (!s) return nullptr;
     s->data_type_ = decl_type_.builtin_type_;
     s->access_ = decl_storage_;
@@ -319,9 +333,8 @@ class Driver {
           return nullptr;
       }
       if (decl_storage_ == Symbol::STATIC_VAR) {
-        s->access_ = Symbol::INDIRECT_VAR;
         return std::make_shared<StaticVarCreate>(std::move(name), decl_type_,
-                                                 allocate_guid(), s->fp_offset_,
+                                                 s->static_slot_,
                                                  std::move(init_cmd));
       } else if (decl_storage_ == Symbol::LOCAL_VAR) {
         return std::make_shared<LocalVarCreate>(
@@ -369,6 +382,9 @@ class Driver {
       case Symbol::INDIRECT_VAR:
         r.reset(new GlobalVariableReference(std::move(name), s->fp_offset_));
         return r;
+      case Symbol::STATIC_VAR:
+        r.reset(new StaticVariableReference(std::move(name), s->static_slot_));
+        return r;
       default:
         error(loc, "Unexpected storage modifier for variable.");
         return nullptr;
@@ -448,10 +464,41 @@ class Driver {
     return ret;
   }
 
-  /// Serializes all commands into bytecode after the parsing.
+  /// Serializes all commands into bytecode after the parsing. Runs the
+  /// bytecode optimizer on the output unless it was turned off.
   /// @param output it the container where the compiled bytecode will go.
   void serialize(std::string* output);
 
+  /// Enables or disables the bytecode optimizer in serialize(). Defaults to
+  /// on.
+  void set_optimize(bool optimize) {
+    optimize_ = optimize;
+  }
+
+  /// @return the number of bytes the last serialize() call rendered before
+  /// the optimizer ran.
+  unsigned unoptimized_size() {
+    return unoptimized_size_;
+  }
+
+  /// Enables recording which source line each piece of bytecode comes
+  /// from. Defaults to off. Must be set before parsing.
+  void set_line_info(bool enabled) {
+    line_info_ = enabled;
+  }
+
+  /// @return true if source line information is recorded.
+  bool line_info() {
+    return line_info_;
+  }
+
+  /// @return the source line table of the bytecode rendered by the last
+  /// serialize() call. Offsets are relative to the beginning of the output
+  /// string. Empty if line info is off.
+  const SourceLineTable& source_lines() {
+    return source_lines_;
+  }
+
   /// lexical context variable that describes what storage option the current
   /// variable declaration has.
   Symbol::Access decl_storage_;
@@ -480,6 +527,20 @@ class Driver {
   // Run the parser on file F.
   // Return 0 on success.
   int parse_file(const std::string& filename);
+
+  /// Runs the parser on source code in memory.
+  /// @param buf is the source code. Does not need to be zero terminated; a
+  /// zero or 0xff byte ends the source.
+  /// @param len is the number of bytes in buf.
+  /// @return 0 on success.
+  int parse_buffer(const char* buf, size_t len);
+
+  /// Runs the parser on source code in memory.
+  /// @param source is the source code.
+  /// @return 0 on success.
+  int parse_string(const std::string& source) {
+    return parse_buffer(source.data(), source.size());
+  }
   // Error handling.
   void error(const yy::location& l, const std::string& m);
   void error(const std::string& m);
@@ -504,6 +565,12 @@ class Driver {
   /// Used later to pass the file name to the location tracker.
   std::string filename_;
 
+  /// Source code to parse when parsing from memory, nullptr when parsing a
+  /// file.
+  const char* source_buf_{nullptr};
+  /// Number of bytes at source_buf_.
+  size_t source_len_{0};
+
   /// Caches the pointer to the string variable where we are serializing the
   /// compiled bytecode.
   std::string* output_root_;
@@ -522,6 +589,21 @@ class Driver {
   /// Next GUID to assign to a variable.
   int next_guid_{1};
 
+  /// Next slot to assign to a static variable.
+  int next_static_slot_{0};
+
+  /// True if the bytecode optimizer should run in serialize().
+  bool optimize_{true};
+
+  /// Size of the bytecode before optimization in the last serialize().
+  unsigned unoptimized_size_{0};
+
+  /// True if the parser should insert SourceLine commands.
+  bool line_info_{false};
+
+  /// Source lines of the bytecode from the last serialize().
+  SourceLineTable source_lines_;
+
   /// The actual parser structures.
   yy::Parser parser{*this};
 };
@@ -0,0 +1,88 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file NativeBlock.cxx
+ *
+ * Registry of logic blocks translated to C++ ahead of time.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include "logic/NativeBlock.hxx"
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#endif
+
+namespace logic {
+
+/// Head of the list of registered translated blocks.
+static NativeBlock* g_native_blocks = nullptr;
+
+NativeBlockRegistration::NativeBlockRegistration(NativeBlock* block)
+    : block_(block) {
+  block_->next = g_native_blocks;
+  g_native_blocks = block_;
+}
+
+NativeBlockRegistration::~NativeBlockRegistration() {
+  for (NativeBlock** p = &g_native_blocks; *p; p = &(*p)->next) {
+    if (*p == block_) {
+      *p = block_->next;
+      return;
+    }
+  }
+}
+
+NativeBlockFn find_native_block(const std::string& bytecode) {
+  for (NativeBlock* b = g_native_blocks; b; b = b->next) {
+    if (b->bytecode_len == bytecode.size() &&
+        memcmp(b->bytecode, bytecode.data(), bytecode.size()) == 0) {
+      return b->fn;
+    }
+  }
+  return nullptr;
+}
+
+bool load_native_library(const std::string& filename, std::string* error) {
+#if defined(__linux__)
+  // The library is never unloaded; its static constructors register the
+  // translated blocks.
+  if (!dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL)) {
+    *error = dlerror();
+    return false;
+  }
+  return true;
+#else
+  *error = "Loading native logic blocks is not supported.";
+  return false;
+#endif
+}
+
+} // namespace logic
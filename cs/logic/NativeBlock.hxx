@@ -0,0 +1,95 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file NativeBlock.hxx
+ *
+ * Registry of logic blocks translated to C++ ahead of time.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#ifndef _LOGIC_NATIVEBLOCK_HXX_
+#define _LOGIC_NATIVEBLOCK_HXX_
+
+#include <stddef.h>
+#include <string>
+
+namespace logic {
+
+class NativeRuntime;
+
+/// Entry point of a logic block that was translated to C++.
+/// @param rt gives the translated code access to the state of the VM.
+/// @param ofs is the byte offset in the bytecode of the block where the
+/// execution starts.
+/// @return same as VM::execute().
+typedef bool (*NativeBlockFn)(NativeRuntime* rt, unsigned ofs);
+
+/// Describes a logic block that was translated to C++. The translated code
+/// is only used for a block whose bytecode is the same as the bytecode it
+/// was translated from.
+struct NativeBlock {
+  /// Bytecode this block was translated from.
+  const char* bytecode;
+  /// Length of bytecode.
+  size_t bytecode_len;
+  /// Translated code.
+  NativeBlockFn fn;
+  /// Next entry in the list of registered blocks.
+  NativeBlock* next;
+};
+
+/// Adds a translated block to the registry while this object is alive. The
+/// translated code has a static instance, so linking it into the binary or
+/// loading it as a shared object makes the block available to every VM.
+class NativeBlockRegistration {
+ public:
+  /// @param block is the translated block. Externally owned, must outlive
+  /// this object.
+  NativeBlockRegistration(NativeBlock* block);
+  ~NativeBlockRegistration();
+
+ private:
+  NativeBlock* block_;
+};
+
+/// Looks up the translated code of a block. Not thread-safe with respect to
+/// loading or unloading translated code.
+/// @param bytecode is the bytecode of the block.
+/// @return the translated code, or nullptr if no translation of this exact
+/// bytecode is registered.
+NativeBlockFn find_native_block(const std::string& bytecode);
+
+/// Loads translated blocks from a shared object. Only supported on Linux.
+/// @param filename is the path to the shared object.
+/// @param error will be filled in with the error message upon failure.
+/// @return true if the shared object was loaded.
+bool load_native_library(const std::string& filename, std::string* error);
+
+} // namespace logic
+
+#endif // _LOGIC_NATIVEBLOCK_HXX_
@@ -0,0 +1,448 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file NativeRuntime.hxx
+ *
+ * Operations used by the C++ code that logic2cxx generates from the bytecode
+ * of a logic block.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#ifndef _LOGIC_NATIVERUNTIME_HXX_
+#define _LOGIC_NATIVERUNTIME_HXX_
+
+#include "logic/NativeBlock.hxx"
+#include "logic/VM.hxx"
+#include "utils/StringPrintf.hxx"
+
+namespace logic {
+
+/// The translated code of a block executes every instruction by calling
+/// these methods on the state of the VM. Most of them return false when the
+/// instruction cannot complete normally (stack underflow, division by zero
+/// etc.), without any side effects. The translated code then calls
+/// fallback(), which executes the instruction again in the VM and continues
+/// there, so the errors are exactly the same as those of the VM.
+class NativeRuntime {
+ public:
+  /// @param vm is the VM executing the block. The IP has to point into the
+  /// block.
+  NativeRuntime(VM* vm) : vm_(vm), block_num_(vm->_ip_block_num_) {}
+
+  /// Counts an instruction as executed.
+  /// @param ofs is the offset of the instruction in the bytecode.
+  void count(unsigned ofs) {
+    if (--vm_->insn_countdown_ == 0) {
+      vm_->insn_period_expired(ip(ofs));
+    }
+  }
+
+  /// Continues the execution in the VM.
+  /// @param ofs is the offset in the bytecode where to continue.
+  /// @return the result of the execution.
+  bool interpret(unsigned ofs) {
+    vm_->jump(ip(ofs));
+    return vm_->execute_interpreted();
+  }
+
+  /// Called when an instruction could not be executed. If the instruction
+  /// already reported an error, returns it, otherwise executes the
+  /// instruction in the VM and continues there.
+  /// @param ofs is the offset of the instruction, which was already counted.
+  /// @return the result of the execution.
+  bool fallback(unsigned ofs) {
+    if (failed_) return false;
+    // The VM will count this instruction again.
+    ++vm_->insn_countdown_;
+    return interpret(ofs);
+  }
+
+  /// Called after a call or return.
+  /// @param ofs will be set to the current IP, if it is in the same block.
+  /// @return true if the execution continues in this block.
+  bool resume(unsigned* ofs) {
+    if (vm_->_ip_block_num_ != block_num_) return false;
+    *ofs = vm_->_ip_ - vm_->_block_start_;
+    return true;
+  }
+
+  /// Continues the execution in the VM from the current IP.
+  /// @return the result of the execution.
+  bool interpret() {
+    return vm_->execute_interpreted();
+  }
+
+  /// TERMINATE or end of code.
+  /// @param next_ofs is the offset after the instruction.
+  /// @return true.
+  bool terminate(unsigned next_ofs) {
+    sync_ip(next_ofs);
+    return true;
+  }
+
+  void push(int value) {
+    stack().push_back(value);
+  }
+
+  bool pop(int* value) {
+    if (stack().empty()) return false;
+    *value = stack().back();
+    stack().pop_back();
+    return true;
+  }
+
+  bool push_top() {
+    if (stack().empty()) return false;
+    stack().push_back(stack().back());
+    return true;
+  }
+
+  bool pop_op() {
+    if (stack().empty()) return false;
+    stack().pop_back();
+    return true;
+  }
+
+  void enter(int count) {
+    stack().resize(stack().size() + count);
+  }
+
+  bool leave(int count) {
+    if (count < 0 || count > (int)stack().size()) return false;
+    stack().resize(stack().size() - count);
+    return true;
+  }
+
+  bool check_stack_length(int length) {
+    return stack().size() == (unsigned)(vm_->fp_ + length);
+  }
+
+  bool store_fp_rel(int relofs) {
+    if (stack().empty()) return false;
+    unsigned ofs = vm_->fp_ + relofs;
+    if (ofs >= stack().size() - 1) return false;
+    stack()[ofs] = stack().back();
+    stack().pop_back();
+    return true;
+  }
+
+  bool load_fp_rel(int relofs) {
+    unsigned ofs = vm_->fp_ + relofs;
+    if (ofs >= stack().size()) return false;
+    stack().push_back(stack()[ofs]);
+    return true;
+  }
+
+  /// @param next_ofs is the offset after the instruction.
+  bool indirect_load(unsigned next_ofs) {
+    int varidx;
+    if (!peek_varidx(&varidx)) return false;
+    stack().pop_back();
+    int value;
+    if (!vm_->indirect_load(vm_->variable_stack_[varidx], &value)) {
+      return access_error(next_ofs);
+    }
+    stack().push_back(value);
+    return true;
+  }
+
+  /// @param next_ofs is the offset after the instruction.
+  bool indirect_store(unsigned next_ofs) {
+    int varidx;
+    if (stack().size() < 2 || !peek_varidx(&varidx)) return false;
+    stack().pop_back();
+    int value = stack().back();
+    stack().pop_back();
+    if (!vm_->indirect_store(vm_->variable_stack_[varidx], value)) {
+      return access_error(next_ofs);
+    }
+    return true;
+  }
+
+  void load_string(const char* data, size_t len) {
+    vm_->string_acc_.assign(data, len);
+  }
+
+  /// @param next_ofs is the offset after the instruction.
+  bool create_var(int guid, int num_states, unsigned next_ofs) {
+    auto& req = vm_->variable_request_;
+    req.name = std::move(vm_->string_acc_);
+    req.block_num = vm_->block_num_;
+    if (num_states >= 0) {
+      req.type = VariableCreationRequest::TYPE_INT;
+      req.num_states = num_states;
+    }
+    auto var = vm_->variable_factory_->create_variable(&req);
+    if (!var) {
+      sync_ip(next_ofs);
+      vm_->error_ =
+          StringPrintf("Error creating variable '%s'.", req.name.c_str());
+      failed_ = true;
+      return false;
+    }
+    req.clear();
+    vm_->external_variables_[guid] = std::move(var);
+    return true;
+  }
+
+  bool import_var() {
+    if (stack().size() < 2) return false;
+    int arg = stack()[stack().size() - 1];
+    int guid = stack()[stack().size() - 2];
+    auto it = vm_->external_variables_.find(guid);
+    if (it == vm_->external_variables_.end()) return false;
+    stack().resize(stack().size() - 2);
+    VM::VMVariableReference ref;
+    ref.var = it->second.get();
+    ref.arg = arg;
+    push_variable(std::move(ref));
+    return true;
+  }
+
+  void create_indirect_var(int fpofs) {
+    VM::VMVariableReference ref;
+    ref.storage = VM::VMVariableReference::OPERAND_STACK;
+    ref.arg = vm_->fp_ + fpofs;
+    push_variable(std::move(ref));
+  }
+
+  bool init_static(int slot) {
+    if (slot < 0) return false;
+    return vm_->init_static(slot);
+  }
+
+  bool load_static(int slot) {
+    const auto& statics = vm_->blocks_[block_num_].statics_;
+    if ((unsigned)slot >= statics.size()) return false;
+    stack().push_back(statics[slot]);
+    return true;
+  }
+
+  bool store_static(int slot) {
+    if (stack().empty() ||
+        (unsigned)slot >= vm_->blocks_[block_num_].statics_.size()) {
+      return false;
+    }
+    int value = stack().back();
+    stack().pop_back();
+    vm_->store_static(block_num_, slot, value);
+    return true;
+  }
+
+  void create_indirect_static(int slot) {
+    VM::VMVariableReference ref;
+    ref.storage = VM::VMVariableReference::STATIC_SLOT;
+    ref.arg = slot;
+    ref.block = block_num_;
+    push_variable(std::move(ref));
+  }
+
+  bool numeric_plus() {
+    return binary([](int lhs, int rhs) { return lhs + rhs; });
+  }
+
+  bool numeric_minus() {
+    return binary([](int lhs, int rhs) { return lhs - rhs; });
+  }
+
+  bool numeric_mul() {
+    return binary([](int lhs, int rhs) { return lhs * rhs; });
+  }
+
+  bool numeric_div() {
+    if (stack().size() < 2 || stack().back() == 0) return false;
+    return binary([](int lhs, int rhs) { return lhs / rhs; });
+  }
+
+  bool numeric_mod() {
+    if (stack().size() < 2 || stack().back() == 0) return false;
+    return binary([](int lhs, int rhs) { return lhs % rhs; });
+  }
+
+  bool bool_eq() {
+    return binary([](int lhs, int rhs) { return (int)(!!lhs == !!rhs); });
+  }
+
+  bool bool_neq() {
+    return binary([](int lhs, int rhs) { return (int)(!!lhs != !!rhs); });
+  }
+
+  bool numeric_leq() {
+    return binary([](int lhs, int rhs) { return (int)(lhs <= rhs); });
+  }
+
+  bool numeric_geq() {
+    return binary([](int lhs, int rhs) { return (int)(lhs >= rhs); });
+  }
+
+  bool numeric_lt() {
+    return binary([](int lhs, int rhs) { return (int)(lhs < rhs); });
+  }
+
+  bool numeric_gt() {
+    return binary([](int lhs, int rhs) { return (int)(lhs > rhs); });
+  }
+
+  bool numeric_eq() {
+    return binary([](int lhs, int rhs) { return (int)(lhs == rhs); });
+  }
+
+  bool numeric_neq() {
+    return binary([](int lhs, int rhs) { return (int)(lhs != rhs); });
+  }
+
+  bool bool_not() {
+    if (stack().empty()) return false;
+    stack().back() = stack().back() == 0 ? 1 : 0;
+    return true;
+  }
+
+  bool bool_project() {
+    if (stack().empty()) return false;
+    stack().back() = stack().back() == 0 ? 0 : 1;
+    return true;
+  }
+
+  void if_preamble() {
+    stack().push_back(vm_->is_preamble_ ? 1 : 0);
+  }
+
+  /// @param num_arg is the number of arguments on the operand stack.
+  /// @param next_ofs is the offset after the instruction.
+  /// @param jumped will be set to true if the execution continues at the
+  /// call target, false if at the next instruction.
+  bool call(int num_arg, unsigned next_ofs, bool* jumped) {
+    auto& cs = vm_->call_stack_;
+    if (cs.empty() || vm_->fp_ != cs.back().fp || stack().empty()) {
+      return false;
+    }
+    int dst = stack().back();
+    stack().pop_back();
+    sync_ip(next_ofs);
+    cs.emplace_back();
+    cs.back().return_address = ip(next_ofs);
+    cs.back().fp = stack().size() - num_arg;
+    vm_->fp_ = cs.back().fp;
+    cs.back().vp = vm_->variable_stack_.size();
+    *jumped = vm_->jump(dst);
+    return true;
+  }
+
+  /// @param next_ofs is the offset after the instruction.
+  /// @param jumped will be set to true if the execution continues at the
+  /// return address, false if at the next instruction.
+  bool ret(unsigned next_ofs, bool* jumped) {
+    auto& cs = vm_->call_stack_;
+    if (cs.size() <= 1) return false;
+    const auto& s = cs.back();
+    vm_->variable_stack_.resize(s.vp);
+    stack().resize(s.fp);
+    VM::ip_t return_address = s.return_address;
+    cs.pop_back();
+    vm_->fp_ = cs.back().fp;
+    sync_ip(next_ofs);
+    *jumped = vm_->jump(return_address);
+    return true;
+  }
+
+  bool print_num() {
+    int value;
+    if (!pop(&value)) return false;
+    vm_->print_cb_(StringPrintf("%d", value));
+    return true;
+  }
+
+  void print_str() {
+    vm_->print_cb_(vm_->string_acc_);
+  }
+
+ private:
+  /// @return the IP of an offset in the current block.
+  VM::ip_t ip(unsigned ofs) {
+    return (block_num_ << VM::BLOCK_CODE_IP_SHIFT) | ofs;
+  }
+
+  /// Sets the IP of the VM to an offset in the current block.
+  void sync_ip(unsigned ofs) {
+    vm_->_ip_ = vm_->_block_start_ + ofs;
+  }
+
+  std::vector<int>& stack() {
+    return vm_->operand_stack_;
+  }
+
+  /// Checks that the top of the operand stack is a valid variable stack
+  /// index.
+  /// @param varidx will be filled in.
+  /// @return false if the stack is empty or the index is invalid.
+  bool peek_varidx(int* varidx) {
+    if (stack().empty()) return false;
+    *varidx = stack().back();
+    return *varidx >= 0 &&
+           (unsigned)*varidx < vm_->variable_stack_.size();
+  }
+
+  /// Reports a variable access error.
+  /// @param next_ofs is the offset after the instruction.
+  /// @return false.
+  bool access_error(unsigned next_ofs) {
+    sync_ip(next_ofs);
+    vm_->access_error();
+    failed_ = true;
+    return false;
+  }
+
+  /// Pushes a reference to the variable stack and its index to the operand
+  /// stack.
+  void push_variable(VM::VMVariableReference ref) {
+    vm_->variable_stack_.emplace_back(std::move(ref));
+    stack().push_back(vm_->variable_stack_.size() - 1);
+  }
+
+  /// Executes a binary operator on the top two entries of the stack.
+  template <class F> bool binary(F fn) {
+    auto& s = stack();
+    if (s.size() < 2) return false;
+    int rhs = s.back();
+    s.pop_back();
+    s.back() = fn(s.back(), rhs);
+    return true;
+  }
+
+  /// The VM whose state we are operating on.
+  VM* vm_;
+  /// Block where the execution started.
+  unsigned block_num_;
+  /// True if the last instruction failed with an error, false if the VM
+  /// should execute it again.
+  bool failed_{false};
+};
+
+} // namespace logic
+
+#endif // _LOGIC_NATIVERUNTIME_HXX_
@@ -34,6 +34,8 @@
 
 #include "logic/OlcbBindings.hxx"
 #include "logic/OlcbBindingsImpl.hxx"
+#include "openlcb/If.hxx"
+#include "os/os.h"
 
 namespace logic {
 
@@ -53,6 +55,57 @@ OlcbVariableFactory::UpdateAction OlcbVariableFactory::apply_configuration(
   }
 }
 
+void OlcbVariableFactory::send_event_message(openlcb::Defs::MTI mti,
+                                             uint64_t event_id,
+                                             unsigned block_num) {
+  if (batching_) {
+    HASSERT(block_num < pending_messages_.size());
+    pending_messages_[block_num].push_back({mti, event_id});
+    return;
+  }
+  long long start = os_get_time_monotonic();
+  helper_.set_wait_for_local_loopback(true);
+  helper_.WriteAsync(node_, mti, openlcb::WriteHelper::global(),
+                     openlcb::eventid_to_buffer(event_id), bn_.reset(&sn_));
+  sn_.wait_for_notification();
+  output_wait_nsec_ += os_get_time_monotonic() - start;
+}
+
+void OlcbVariableFactory::send_write_batch() {
+  auto* flow = node_->iface()->global_message_write_flow();
+  for (auto& block_messages : pending_messages_) {
+    if (block_messages.empty()) continue;
+    if (!batch_in_flight_) {
+      bn_.reset(&sn_);
+      batch_in_flight_ = true;
+    }
+    batch_sent_ = true;
+    for (const auto& m : block_messages) {
+      auto* b = flow->alloc();
+      b->data()->reset(m.mti, node_->node_id(),
+                       openlcb::eventid_to_buffer(m.event_id));
+      b->data()->set_flag_dst(openlcb::GenMessage::WAIT_FOR_LOCAL_LOOPBACK);
+      b->set_done(bn_.new_child());
+      flow->send(b);
+    }
+    block_messages.clear();
+  }
+}
+
+bool OlcbVariableFactory::end_write_batch() {
+  send_write_batch();
+  batching_ = false;
+  bool sent = batch_sent_;
+  batch_sent_ = false;
+  if (!batch_in_flight_) return sent;
+  long long start = os_get_time_monotonic();
+  bn_.notify();
+  sn_.wait_for_notification();
+  batch_in_flight_ = false;
+  output_wait_nsec_ += os_get_time_monotonic() - start;
+  return sent;
+}
+
 void OlcbVariableFactory::factory_reset(int fd) {
   for (unsigned bl = 0; bl < cfg_.blocks().num_repeats(); ++bl) {
     const auto& block = cfg_.blocks().entry(bl);
@@ -89,7 +142,8 @@ std::unique_ptr<Variable> OlcbVariableFactory::create_variable(
       /// @todo define non-boolean variables as well.
       auto event_on = e.event_on().read(config_fd_);
       auto event_off = e.event_off().read(config_fd_);
-      return std::unique_ptr<Variable>(new OlcbBoolVariable(event_on, event_off, this));
+      return std::unique_ptr<Variable>(new OlcbBoolVariable(
+          event_on, event_off, this, request->block_num));
     } else if (name.empty() && freeidx < 0) {
       freeidx = varidx;
     }
@@ -104,7 +158,8 @@ std::unique_ptr<Variable> OlcbVariableFactory::create_variable(
   e.name().write(config_fd_, request->name);
   auto event_on = e.event_on().read(config_fd_);
   auto event_off = e.event_off().read(config_fd_);
-  return std::unique_ptr<Variable>(new OlcbBoolVariable(event_on, event_off, this));
+  return std::unique_ptr<Variable>(new OlcbBoolVariable(
+          event_on, event_off, this, request->block_num));
 }
 
 
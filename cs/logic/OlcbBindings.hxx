@@ -42,12 +42,17 @@
 #include "openlcb/Node.hxx"
 #include "openlcb/WriteHelper.hxx"
 
+#include <vector>
+
 namespace logic {
 
 class OlcbVariableFactory : public VariableFactory,
                             public DefaultConfigUpdateListener {
  public:
-  OlcbVariableFactory(openlcb::Node* node, const logic::LogicConfig& cfg) : node_(node), cfg_(cfg) {}
+  OlcbVariableFactory(openlcb::Node* node, const logic::LogicConfig& cfg)
+      : node_(node),
+        pending_messages_(cfg.blocks().num_repeats()),
+        cfg_(cfg) {}
   ~OlcbVariableFactory();
   
   openlcb::Node* get_node() const { return node_; }
@@ -83,10 +88,65 @@ class OlcbVariableFactory : public VariableFactory,
   openlcb::Node* node() {
     return node_;
   }
+
+  /// Called by the variables when their state was changed by a message from
+  /// the network. Schedules the owning block and wakes up the runner.
+  /// @param block_num is the logic block that uses the variable.
+  void network_variable_changed(unsigned block_num) {
+    variable_changed(block_num);
+    runner_.wakeup();
+  }
+
+  /// Starts collecting the event messages (event reports of variable writes,
+  /// identify queries of newly created variables) instead of sending each
+  /// one synchronously.
+  void begin_write_batch() {
+    batching_ = batching_enabled_;
+  }
+
+  /// Enables or disables the write batches. When disabled,
+  /// begin_write_batch() has no effect and every event message is sent
+  /// synchronously, so a block sees the writes of the blocks before it in
+  /// the same step. Batching is enabled by default.
+  void set_write_batching(bool enabled) {
+    batching_enabled_ = enabled;
+  }
+
+  /// Sends all collected event messages to the network without waiting for
+  /// them to go out. The messages are sent in the order of the blocks that
+  /// produced them.
+  void send_write_batch();
+
+  /// Sends all remaining collected event messages, then waits until all
+  /// messages of the batch are processed (including local loopback). Ends the
+  /// batch.
+  /// @return true if any message was sent in this batch.
+  bool end_write_batch();
+
+  /// @return the total time in nanoseconds the logic thread spent blocked
+  /// waiting for event messages to go out.
+  long long output_wait_nsec() {
+    return output_wait_nsec_;
+  }
   
  private:
   friend class OlcbBoolVariable;
   friend class OlcbIntVariable;
+
+  /// Sends an event message (event report or identify query). If a batch is
+  /// open, the message is queued, otherwise sent synchronously. While a batch
+  /// is open, different blocks may call this concurrently.
+  /// @param mti is the message type to send.
+  /// @param event_id is the event ID payload.
+  /// @param block_num is the logic block that owns the variable.
+  void send_event_message(openlcb::Defs::MTI mti, uint64_t event_id,
+                          unsigned block_num);
+
+  /// An event message queued in a batch.
+  struct PendingMessage {
+    openlcb::Defs::MTI mti;
+    uint64_t event_id;
+  };
   
   /// Node object that will be used to communicate with the OpenLCB bus.
   openlcb::Node* node_;
@@ -98,6 +158,20 @@ class OlcbVariableFactory : public VariableFactory,
   SyncNotifiable sn_;
   /// Notifiable to give to the helper.
   BarrierNotifiable bn_;
+
+  /// Event messages waiting to be sent in the current batch, indexed by the
+  /// logic block that produced them.
+  std::vector<std::vector<PendingMessage>> pending_messages_;
+  /// Total time spent waiting for event output, in nanoseconds.
+  long long output_wait_nsec_{0};
+  /// True if event messages should be collected in pending_messages_.
+  bool batching_{false};
+  /// False if begin_write_batch() should not open a batch.
+  bool batching_enabled_{true};
+  /// True if bn_ has been reset for a batch and is waiting for the children.
+  bool batch_in_flight_{false};
+  /// True if any message was sent since begin_write_batch().
+  bool batch_sent_{false};
   
   /// Pointer to the configuration data.
   logic::LogicConfig cfg_;
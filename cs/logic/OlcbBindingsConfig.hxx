@@ -77,12 +77,40 @@ CDI_GROUP_ENTRY(enabled, openlcb::Uint8ConfigEntry, Default(0), Min(0), Max(1),
 CDI_GROUP_ENTRY(body, LogicBlockBody);
 CDI_GROUP_END();
 
-using ReptBlock = openlcb::RepeatedGroup<LogicBlock, 8>;
+/// Number of logic blocks a node can run.
+static constexpr unsigned NUM_LOGIC_BLOCKS = 8;
+
+using ReptBlock = openlcb::RepeatedGroup<LogicBlock, NUM_LOGIC_BLOCKS>;
 
 CDI_GROUP(LogicConfig);
 CDI_GROUP_ENTRY(blocks, ReptBlock, RepName("Block"));
 CDI_GROUP_END();
 
+/// Memory space number where the execution profile of the logic blocks can
+/// be read.
+static constexpr uint8_t LOGIC_PROFILE_SPACE = 0x4C;
+
+CDI_GROUP(LogicBlockProfile);
+CDI_GROUP_ENTRY(
+    report, openlcb::StringConfigEntry<256>, Name("Execution profile"),
+    Description("Read-only. Statistics since the block was last compiled: "
+                "number of runs, run time, instructions executed, external "
+                "variable accesses and the source lines that the most time "
+                "is spent on."));
+CDI_GROUP_END();
+
+using ReptBlockProfile =
+    openlcb::RepeatedGroup<LogicBlockProfile, NUM_LOGIC_BLOCKS>;
+
+/// Segment for the live execution statistics of the logic blocks. This is
+/// not stored anywhere; see LogicProfileSpace.
+CDI_GROUP(LogicProfileSegment, Segment(LOGIC_PROFILE_SPACE), Offset(0),
+          Name("Logic block profile"),
+          Description("Live execution statistics of the logic blocks. Use "
+                      "Refresh to update."));
+CDI_GROUP_ENTRY(blocks, ReptBlockProfile, RepName("Block"));
+CDI_GROUP_END();
+
 } // namespace logic
 
 
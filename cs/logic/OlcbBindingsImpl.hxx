@@ -47,19 +47,24 @@ struct BindingsHelper {
 
 class OlcbBoolVariable : public Variable, private openlcb::BitEventInterface {
  public:
+  /// Constructor.
+  /// @param event_on is the event ID for the true state.
+  /// @param event_off is the event ID for the false state.
+  /// @param parent is the variable factory that owns *this.
+  /// @param block_num is the logic block that uses this variable.
   OlcbBoolVariable(uint64_t event_on, uint64_t event_off,
-                   OlcbVariableFactory *parent)
+                   OlcbVariableFactory *parent, uint8_t block_num = 0)
       : BitEventInterface(event_on, event_off),
         state_(false),
         state_known_(false),
+        block_num_(block_num),
         parent_(parent) {
-    // This will ensure that all local variables have replied to this query
-    // before continuing. 
-    parent_->helper_.set_wait_for_local_loopback(true);
-    pc_.SendQueryProducer(&parent_->helper_, parent_->bn_.reset(&parent_->sn_));
-    parent_->sn_.wait_for_notification();
-    pc_.SendQueryConsumer(&parent_->helper_, parent_->bn_.reset(&parent_->sn_));
-    parent_->sn_.wait_for_notification();
+    // Queries the current state from the network. During a compile these
+    // are collected and sent in one burst with all other variables.
+    parent_->send_event_message(openlcb::Defs::MTI_PRODUCER_IDENTIFY,
+                                event_on, block_num_);
+    parent_->send_event_message(openlcb::Defs::MTI_CONSUMER_IDENTIFY,
+                                event_on, block_num_);
   }
 
   int max_state() override {
@@ -78,9 +83,10 @@ class OlcbBoolVariable : public Variable, private openlcb::BitEventInterface {
     if (!state_ && value) need_update = true;
     state_ = value ? true : false;
     if (need_update) {
-      parent_->helper_.set_wait_for_local_loopback(true);
-      pc_.SendEventReport(&parent_->helper_, parent_->bn_.reset(&parent_->sn_));
-      parent_->sn_.wait_for_notification();
+      parent_->variable_changed(block_num_);
+      parent_->send_event_message(openlcb::Defs::MTI_EVENT_REPORT,
+                                   state_ ? event_on() : event_off(),
+                                   block_num_);
     }
   }
 
@@ -96,8 +102,12 @@ class OlcbBoolVariable : public Variable, private openlcb::BitEventInterface {
   }
   void set_state(bool new_value) override
   {
+    bool changed = !state_known_ || (state_ != new_value);
     state_known_ = true;
     state_ = new_value;
+    if (changed) {
+      parent_->network_variable_changed(block_num_);
+    }
   }
 
   /// The current state of the variable as seen by the internal
@@ -107,6 +117,8 @@ class OlcbBoolVariable : public Variable, private openlcb::BitEventInterface {
   /// if 0, network queries will return UNKNOWN. If 1, network queries will
   /// return the state as defined by the state_ variable.
   uint8_t state_known_ : 1;
+  /// Logic block that uses this variable.
+  uint8_t block_num_;
   /// Pointer to the Olcb variable factory that owns this. externally owned.
   OlcbVariableFactory* parent_;
   /// Implementation of the producer-consumer event handler.
@@ -128,7 +140,7 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
   void write(const VariableFactory *parent, unsigned arg, int value) override {
     if (value < 0 || value >= num_states_) {
       // ignore bad writes.
-      parent_->report_access_error();
+      parent_->report_access_error(block_num_);
       return;
     }
     bool need_update = !state_known_;
@@ -136,13 +148,9 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
     if (((int)state_) != value) need_update = true;
     state_ = value;
     if (need_update) {
-      parent_->helper_.set_wait_for_local_loopback(true);
-      parent_->helper_.WriteAsync(
-          node(), openlcb::Defs::MTI_EVENT_REPORT,
-          openlcb::WriteHelper::global(),
-          openlcb::eventid_to_buffer(event_base_ + state_),
-          parent_->bn_.reset(&parent_->sn_));
-      parent_->sn_.wait_for_notification();
+      parent_->variable_changed(block_num_);
+      parent_->send_event_message(openlcb::Defs::MTI_EVENT_REPORT,
+                                   event_base_ + state_, block_num_);
     }
   }
 
@@ -156,26 +164,26 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
   /// @param num_states is the number of consecutive event IDs that are
   /// meaningful starting with event_base.
   /// @param parent is the variable factory that owns *this.
+  /// @param block_num is the logic block that uses this variable.
   OlcbIntVariable(uint64_t event_base, uint8_t num_states,
-                  OlcbVariableFactory* parent)
+                  OlcbVariableFactory* parent, uint8_t block_num = 0)
       : event_base_(event_base),
         state_known_(false),
         state_(0),
         num_states_(num_states),
+        block_num_(block_num),
         parent_(parent) {
     uint64_t reg_event = event_base_;
     unsigned mask = openlcb::EventRegistry::align_mask(&reg_event, num_states_);
     openlcb::EventRegistry::instance()->register_handler(
         EventRegistryEntry(this, reg_event, 0), mask);
 
+    // When sent synchronously, we stop querying as soon as the state is
+    // known. In a batch all states are queried.
     StateType ofs = 0;
     while (!state_known_ && ofs < num_states_) {
-      parent_->helper_.set_wait_for_local_loopback(true);
-      parent_->helper_.WriteAsync(node(), openlcb::Defs::MTI_CONSUMER_IDENTIFY,
-                                  openlcb::WriteHelper::global(),
-                                  openlcb::eventid_to_buffer(event_base_ + ofs),
-                                  parent_->bn_.reset(&parent_->sn_));
-      parent_->sn_.wait_for_notification();
+      parent_->send_event_message(openlcb::Defs::MTI_CONSUMER_IDENTIFY,
+                                  event_base_ + ofs, block_num_);
       ++ofs;
     }
   }
@@ -188,9 +196,7 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
                            openlcb::EventReport *event,
                            BarrierNotifiable *done) override {
     AutoNotify an(done);
-    if (decode_event(event->event, &state_)) {
-      state_known_ = true;
-    }
+    update_state(event->event);
   }
 
   void handle_identify_consumer(
@@ -247,9 +253,7 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
     AutoNotify an(done);
     if (state_known_) return;
     if (event->state != openlcb::EventState::VALID) return;
-    if (decode_event(event->event, &state_)) {
-      state_known_ = true;
-    }
+    update_state(event->event);
   }
 
   void handle_producer_identified(
@@ -258,9 +262,7 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
     AutoNotify an(done);
     if (state_known_) return;
     if (event->state != openlcb::EventState::VALID) return;
-    if (decode_event(event->event, &state_)) {
-      state_known_ = true;
-    }
+    update_state(event->event);
   }
   
   void handle_identify_global(const openlcb::EventRegistryEntry &registry_entry,
@@ -313,12 +315,28 @@ class OlcbIntVariable : public Variable, private openlcb::SimpleEventHandler {
     return true;
   }
 
+  /// Sets the state from an event that arrived from the network. Schedules
+  /// the logic block if the state changed.
+  /// @param event_id event coming from the network.
+  void update_state(uint64_t event_id) {
+    StateType st;
+    if (!decode_event(event_id, &st)) return;
+    bool changed = !state_known_ || (st != state_);
+    state_ = st;
+    state_known_ = true;
+    if (changed) {
+      parent_->network_variable_changed(block_num_);
+    }
+  }
+
   uint64_t event_base_;
   uint8_t state_known_ : 1;
   StateType state_;
   /// Number of different states. Largest event valid is event_base_ +
   /// num_states_ - 1.
   StateType num_states_;
+  /// Logic block that uses this variable.
+  uint8_t block_num_;
   /// Pointer to the Olcb variable factory that owns this. externally owned.
   OlcbVariableFactory* parent_;
 };
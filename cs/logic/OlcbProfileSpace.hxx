@@ -0,0 +1,116 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file OlcbProfileSpace.hxx
+ *
+ * Memory space that exports the execution profile of the logic blocks.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#ifndef _LOGIC_OLCBPROFILESPACE_HXX_
+#define _LOGIC_OLCBPROFILESPACE_HXX_
+
+#include <string.h>
+
+#include "logic/OlcbBindingsConfig.hxx"
+#include "logic/Runner.hxx"
+#include "openlcb/MemoryConfig.hxx"
+
+namespace logic {
+
+/// Read-only memory space that renders the execution profile of each logic
+/// block upon read. The layout is described by LogicProfileSegment; add that
+/// to the CDI of the node.
+class LogicProfileSpace : private openlcb::MemorySpace {
+ public:
+  static constexpr unsigned SPACE_ID =
+      LogicProfileSegment::group_opts().segment();
+  /// Size of the text for one block.
+  static constexpr unsigned ENTRY_SIZE = LogicBlockProfile::size();
+  static constexpr unsigned MAX_ADDRESS =
+      LogicProfileSegment::group_opts().get_segment_offset() +
+      LogicProfileSegment::size() - 1;
+
+  /// Constructor. Registers the memory space.
+  /// @param parent is the memory config handler of the node.
+  /// @param runner is the logic runner whose blocks we report on.
+  /// @param node is the virtual node to register for.
+  LogicProfileSpace(openlcb::MemoryConfigHandler* parent, Runner* runner,
+                    openlcb::Node* node)
+      : parent_(parent), runner_(runner), node_(node) {
+    parent_->registry()->insert(node_, SPACE_ID, this);
+  }
+
+  ~LogicProfileSpace() {
+    parent_->registry()->erase(node_, SPACE_ID, this);
+  }
+
+ private:
+  address_t max_address() override {
+    return MAX_ADDRESS;
+  }
+
+  size_t read(address_t source, uint8_t* dst, size_t len, errorcode_t* error,
+              Notifiable* again) override {
+    if (source > MAX_ADDRESS) {
+      *error = openlcb::MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
+      return 0;
+    }
+    unsigned block_num = source / ENTRY_SIZE;
+    unsigned ofs = source % ENTRY_SIZE;
+    if (ofs == 0 || block_num != report_block_) {
+      // A read of a whole entry comes in multiple pieces. We render the text
+      // at the first one so that the pieces are consistent.
+      report_ = runner_->profile_report(block_num);
+      report_.resize(ENTRY_SIZE - 1);
+      report_.push_back(0);
+      report_block_ = block_num;
+    }
+    if (len > ENTRY_SIZE - ofs) {
+      len = ENTRY_SIZE - ofs;
+    }
+    memcpy(dst, report_.data() + ofs, len);
+    *error = 0;
+    return len;
+  }
+
+  /// Memory config handler we registered with.
+  openlcb::MemoryConfigHandler* parent_;
+  /// Logic runner to query.
+  Runner* runner_;
+  /// Node we registered for.
+  openlcb::Node* node_;
+  /// Text for the block report_block_, padded with zeros to ENTRY_SIZE.
+  std::string report_;
+  /// Which block report_ belongs to.
+  unsigned report_block_{(unsigned)-1};
+};
+
+} // namespace logic
+
+#endif // _LOGIC_OLCBPROFILESPACE_HXX_
@@ -0,0 +1,658 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Optimizer.cxx
+ *
+ * Optimizing pass that runs on the compiled bytecode before it is handed to
+ * the VM.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include "logic/Optimizer.hxx"
+
+#include <limits.h>
+
+namespace logic {
+
+/// How many times we run all passes at most.
+static constexpr unsigned MAX_OPTIMIZER_ROUNDS = 16;
+/// How many jumps we follow when threading a jump chain.
+static constexpr unsigned MAX_JUMP_CHAIN = 8;
+/// How many times we try to lay out the code before giving up.
+static constexpr unsigned MAX_ENCODE_ROUNDS = 8;
+
+/// @return how many bytes a varint takes in the bytecode.
+static unsigned varint_size(int value) {
+  std::string tmp;
+  BytecodeStream::append_varint(&tmp, value);
+  return tmp.size();
+}
+
+// static
+bool BytecodeOptimizer::optimize(std::string* code, unsigned base_ofs,
+                                 SourceLineTable* lines) {
+  BytecodeOptimizer opt(base_ofs);
+  if (!opt.decode(*code)) {
+    return false;
+  }
+  opt.strip_source_lines();
+  for (unsigned round = 0; round < MAX_OPTIMIZER_ROUNDS; ++round) {
+    bool changed = false;
+    opt.compute_targets();
+    changed |= opt.peephole();
+    opt.compact();
+    opt.compute_targets();
+    changed |= opt.thread_jumps();
+    changed |= opt.remove_dead_code();
+    opt.compact();
+    if (!changed) break;
+  }
+  std::string output;
+  SourceLineTable new_lines;
+  if (!opt.encode(&output, lines ? &new_lines : nullptr)) {
+    return false;
+  }
+  if (output.size() > code->size()) {
+    // Can only happen if the jump offsets grew in the encoding. Not worth
+    // it.
+    return false;
+  }
+  code->swap(output);
+  if (lines) {
+    lines->insert(lines->end(), new_lines.begin(), new_lines.end());
+  }
+  return true;
+}
+
+// static
+void BytecodeOptimizer::collect_source_lines(const std::string& code,
+                                             unsigned base_ofs,
+                                             SourceLineTable* lines) {
+  const uint8_t* start = (const uint8_t*)code.data();
+  const uint8_t* eof = start + code.size();
+  const uint8_t* ip = start;
+  while (ip < eof) {
+    unsigned ofs = ip - start;
+    OpCode opcode = (OpCode)*ip++;
+    int arg;
+    switch (operand_format(opcode)) {
+      case OPERAND_NONE:
+        break;
+      case OPERAND_VARINT:
+        if (!BytecodeStream::decode_varint(&ip, eof, &arg)) return;
+        if (opcode == SOURCE_LINE) {
+          lines->push_back({base_ofs + ofs, (unsigned)arg});
+        }
+        break;
+      case OPERAND_TWO_VARINTS:
+        if (!BytecodeStream::decode_varint(&ip, eof, &arg)) return;
+        if (!BytecodeStream::decode_varint(&ip, eof, &arg)) return;
+        break;
+      case OPERAND_STRING:
+        if (!BytecodeStream::decode_varint(&ip, eof, &arg)) return;
+        if (arg < 0 || ip + arg > eof) return;
+        ip += arg;
+        break;
+      case OPERAND_UNKNOWN:
+        return;
+    }
+  }
+}
+
+// static
+BytecodeOptimizer::OperandFormat BytecodeOptimizer::operand_format(
+    OpCode opcode) {
+  switch (opcode) {
+    case TERMINATE:
+    case PUSH_CONSTANT_0:
+    case PUSH_CONSTANT_1:
+    case PUSH_TOP:
+    case POP_OP:
+    case INDIRECT_LOAD:
+    case INDIRECT_STORE:
+    case IMPORT_VAR:
+    case NUMERIC_PLUS:
+    case NUMERIC_MINUS:
+    case NUMERIC_MUL:
+    case NUMERIC_DIV:
+    case NUMERIC_MOD:
+    case BOOL_EQ:
+    case BOOL_NEQ:
+    case NUMERIC_LEQ:
+    case NUMERIC_GEQ:
+    case NUMERIC_LT:
+    case NUMERIC_GT:
+    case NUMERIC_EQ:
+    case NUMERIC_NEQ:
+    case BOOL_NOT:
+    case BOOL_PROJECT:
+    case IF_PREAMBLE:
+    case RET:
+    case PRINT_NUM:
+    case PRINT_STR:
+    case NOP:
+      return OPERAND_NONE;
+    case PUSH_CONSTANT:
+    case ENTER:
+    case LEAVE:
+    case CHECK_STACK_LENGTH:
+    case STORE_FP_REL:
+    case LOAD_FP_REL:
+    case INIT_STATIC:
+    case LOAD_STATIC:
+    case STORE_STATIC:
+    case CREATE_INDIRECT_STATIC:
+    case CREATE_INDIRECT_VAR:
+    case JUMP:
+    case CALL:
+    case TEST_JUMP_IF_FALSE:
+    case TEST_JUMP_IF_TRUE:
+    case SOURCE_LINE:
+      return OPERAND_VARINT;
+    case CREATE_VAR:
+      return OPERAND_TWO_VARINTS;
+    case LOAD_STRING:
+      return OPERAND_STRING;
+    default:
+      return OPERAND_UNKNOWN;
+  }
+}
+
+bool BytecodeOptimizer::decode(const std::string& code) {
+  const uint8_t* start = (const uint8_t*)code.data();
+  const uint8_t* eof = start + code.size();
+  const uint8_t* ip = start;
+  // Instruction index for each byte offset, -1 if not an instruction start.
+  std::vector<int> index_at(code.size() + 1, -1);
+  // Byte offset of the jump/call target for each instruction.
+  std::vector<int> target_ofs;
+  insns_.clear();
+  while (ip < eof) {
+    index_at[ip - start] = insns_.size();
+    insns_.emplace_back();
+    Insn& insn = insns_.back();
+    insn.opcode = (OpCode)*ip++;
+    switch (operand_format(insn.opcode)) {
+      case OPERAND_NONE:
+        break;
+      case OPERAND_VARINT:
+        if (!BytecodeStream::decode_varint(&ip, eof, &insn.arg)) return false;
+        break;
+      case OPERAND_TWO_VARINTS:
+        if (!BytecodeStream::decode_varint(&ip, eof, &insn.arg)) return false;
+        if (!BytecodeStream::decode_varint(&ip, eof, &insn.arg2)) return false;
+        break;
+      case OPERAND_STRING: {
+        int len;
+        if (!BytecodeStream::decode_varint(&ip, eof, &len)) return false;
+        if (len < 0 || ip + len > eof) return false;
+        insn.str.assign((const char*)ip, len);
+        ip += len;
+        break;
+      }
+      case OPERAND_UNKNOWN:
+        return false;
+    }
+    if (is_jump(insn)) {
+      target_ofs.push_back(ip - start + insn.arg);
+    } else {
+      target_ofs.push_back(-1);
+    }
+  }
+  index_at[code.size()] = insns_.size();
+  // The function addresses are pushed as constants right before the CALL.
+  for (unsigned i = 0; i + 1 < insns_.size(); ++i) {
+    if (insns_[i].opcode == PUSH_CONSTANT && insns_[i + 1].opcode == CALL) {
+      int ofs = (insns_[i].arg & 0xFFFF) - (int)base_ofs_;
+      if (ofs < 0 || ofs >= (int)code.size()) return false;
+      insns_[i].arg2 = insns_[i].arg & ~0xFFFF;
+      target_ofs[i] = ofs;
+    }
+  }
+  for (unsigned i = 0; i < insns_.size(); ++i) {
+    int ofs = target_ofs[i];
+    if (ofs < 0) continue;
+    if (ofs > (int)code.size() || index_at[ofs] < 0) {
+      // Jump into the middle of an instruction or out of the code.
+      return false;
+    }
+    insns_[i].target = index_at[ofs];
+  }
+  return true;
+}
+
+void BytecodeOptimizer::strip_source_lines() {
+  unsigned line = 0;
+  bool found = false;
+  for (auto& insn : insns_) {
+    if (insn.opcode == SOURCE_LINE) {
+      line = insn.arg;
+      insn.deleted = true;
+      found = true;
+    } else {
+      insn.line = line;
+    }
+  }
+  if (found) compact();
+}
+
+bool BytecodeOptimizer::encode(std::string* output, SourceLineTable* lines) {
+  unsigned n = insns_.size();
+  // Byte offset of each instruction, plus the end of code.
+  std::vector<unsigned> ofs(n + 1, 0);
+  std::vector<unsigned> size(n, 1);
+  // Computes the instruction sizes. Jump offsets depend on the sizes, so we
+  // iterate until the layout is stable.
+  bool stable = false;
+  for (unsigned round = 0; !stable && round < MAX_ENCODE_ROUNDS; ++round) {
+    for (unsigned i = 0; i < n; ++i) {
+      ofs[i + 1] = ofs[i] + size[i];
+    }
+    stable = true;
+    for (unsigned i = 0; i < n; ++i) {
+      const Insn& insn = insns_[i];
+      unsigned sz = 1;
+      int value;
+      if (is_jump(insn)) {
+        sz += varint_size(ofs[insn.target] - (ofs[i] + size[i]));
+      } else if (insn.target >= 0) {
+        sz += varint_size(insn.arg2 | (base_ofs_ + ofs[insn.target]));
+      } else if (get_constant(insn, &value)) {
+        if (value != 0 && value != 1) sz += varint_size(value);
+      } else {
+        switch (operand_format(insn.opcode)) {
+          case OPERAND_VARINT:
+            sz += varint_size(insn.arg);
+            break;
+          case OPERAND_TWO_VARINTS:
+            sz += varint_size(insn.arg) + varint_size(insn.arg2);
+            break;
+          case OPERAND_STRING:
+            sz += varint_size(insn.str.size()) + insn.str.size();
+            break;
+          default:
+            break;
+        }
+      }
+      if (sz != size[i]) {
+        size[i] = sz;
+        stable = false;
+      }
+    }
+  }
+  if (!stable) return false;
+
+  output->clear();
+  for (unsigned i = 0; i < n; ++i) {
+    const Insn& insn = insns_[i];
+    int value;
+    if (is_jump(insn)) {
+      BytecodeStream::append_opcode(output, insn.opcode);
+      BytecodeStream::append_varint(output,
+                                    ofs[insn.target] - (ofs[i] + size[i]));
+    } else if (insn.target >= 0) {
+      BytecodeStream::append_opcode(output, PUSH_CONSTANT);
+      BytecodeStream::append_varint(output,
+                                    insn.arg2 | (base_ofs_ + ofs[insn.target]));
+    } else if (get_constant(insn, &value)) {
+      if (value == 0) {
+        BytecodeStream::append_opcode(output, PUSH_CONSTANT_0);
+      } else if (value == 1) {
+        BytecodeStream::append_opcode(output, PUSH_CONSTANT_1);
+      } else {
+        BytecodeStream::append_opcode(output, PUSH_CONSTANT);
+        BytecodeStream::append_varint(output, value);
+      }
+    } else {
+      BytecodeStream::append_opcode(output, insn.opcode);
+      switch (operand_format(insn.opcode)) {
+        case OPERAND_VARINT:
+          BytecodeStream::append_varint(output, insn.arg);
+          break;
+        case OPERAND_TWO_VARINTS:
+          BytecodeStream::append_varint(output, insn.arg);
+          BytecodeStream::append_varint(output, insn.arg2);
+          break;
+        case OPERAND_STRING:
+          BytecodeStream::append_string(output, insn.str);
+          break;
+        default:
+          break;
+      }
+    }
+    HASSERT(output->size() == ofs[i + 1]);
+    // Code before the first source line needs no entry, same as in the
+    // unoptimized code.
+    if (lines && insn.line != (lines->empty() ? 0 : lines->back().line)) {
+      lines->push_back({base_ofs_ + ofs[i], insn.line});
+    }
+  }
+  return true;
+}
+
+// static
+bool BytecodeOptimizer::is_jump(const Insn& insn) {
+  return insn.opcode == JUMP || insn.opcode == TEST_JUMP_IF_FALSE ||
+         insn.opcode == TEST_JUMP_IF_TRUE;
+}
+
+// static
+bool BytecodeOptimizer::get_constant(const Insn& insn, int* value) {
+  switch (insn.opcode) {
+    case PUSH_CONSTANT_0:
+      *value = 0;
+      return true;
+    case PUSH_CONSTANT_1:
+      *value = 1;
+      return true;
+    case PUSH_CONSTANT:
+      if (insn.target >= 0) return false;
+      *value = insn.arg;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// static
+void BytecodeOptimizer::set_constant(Insn* insn, int value) {
+  insn->opcode = PUSH_CONSTANT;
+  insn->arg = value;
+  insn->target = -1;
+}
+
+// static
+bool BytecodeOptimizer::fold_binary(OpCode opcode, int lhs, int rhs,
+                                    int* result) {
+  // The VM computes in int, which wraps around on all our targets.
+  unsigned ul = lhs;
+  unsigned ur = rhs;
+  switch (opcode) {
+    case NUMERIC_PLUS:
+      *result = (int)(ul + ur);
+      return true;
+    case NUMERIC_MINUS:
+      *result = (int)(ul - ur);
+      return true;
+    case NUMERIC_MUL:
+      *result = (int)(ul * ur);
+      return true;
+    case NUMERIC_DIV:
+      if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) return false;
+      *result = lhs / rhs;
+      return true;
+    case NUMERIC_MOD:
+      if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) return false;
+      *result = lhs % rhs;
+      return true;
+    case BOOL_EQ:
+      *result = (!!lhs == !!rhs);
+      return true;
+    case BOOL_NEQ:
+      *result = (!!lhs != !!rhs);
+      return true;
+    case NUMERIC_LEQ:
+      *result = (lhs <= rhs);
+      return true;
+    case NUMERIC_GEQ:
+      *result = (lhs >= rhs);
+      return true;
+    case NUMERIC_LT:
+      *result = (lhs < rhs);
+      return true;
+    case NUMERIC_GT:
+      *result = (lhs > rhs);
+      return true;
+    case NUMERIC_EQ:
+      *result = (lhs == rhs);
+      return true;
+    case NUMERIC_NEQ:
+      *result = (lhs != rhs);
+      return true;
+    default:
+      return false;
+  }
+}
+
+void BytecodeOptimizer::compute_targets() {
+  is_target_.assign(insns_.size() + 1, false);
+  for (const auto& insn : insns_) {
+    if (insn.target >= 0) {
+      is_target_[insn.target] = true;
+    }
+  }
+}
+
+void BytecodeOptimizer::compact() {
+  unsigned n = insns_.size();
+  // New index of each old instruction. Deleted instructions map to the next
+  // kept one.
+  std::vector<int> new_index(n + 1);
+  unsigned kept = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    new_index[i] = kept;
+    if (!insns_[i].deleted) ++kept;
+  }
+  new_index[n] = kept;
+  unsigned dst = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    if (insns_[i].deleted) continue;
+    if (dst != i) {
+      insns_[dst] = std::move(insns_[i]);
+    }
+    if (insns_[dst].target >= 0) {
+      insns_[dst].target = new_index[insns_[dst].target];
+    }
+    ++dst;
+  }
+  insns_.resize(kept);
+}
+
+bool BytecodeOptimizer::peephole() {
+  bool changed = false;
+  unsigned n = insns_.size();
+  for (unsigned i = 0; i < n; ++i) {
+    Insn& a = insns_[i];
+    if (a.deleted) continue;
+    if (a.opcode == NOP ||
+        ((a.opcode == ENTER || a.opcode == LEAVE) && a.arg == 0) ||
+        (is_jump(a) && a.target == (int)i + 1)) {
+      // Does nothing. A conditional jump to the next instruction still
+      // consumes its operand.
+      if (a.opcode == TEST_JUMP_IF_FALSE || a.opcode == TEST_JUMP_IF_TRUE) {
+        a.opcode = POP_OP;
+        a.target = -1;
+      } else {
+        a.deleted = true;
+      }
+      changed = true;
+      continue;
+    }
+    // The rewrites below span multiple instructions; nobody may jump into
+    // the middle.
+    if (i + 1 >= n || is_target(i + 1)) continue;
+    Insn& b = insns_[i + 1];
+    int ca, cb, result;
+    bool a_const = get_constant(a, &ca);
+    if (a_const && (b.opcode == BOOL_NOT || b.opcode == BOOL_PROJECT)) {
+      set_constant(&a, b.opcode == BOOL_NOT ? !ca : !!ca);
+      b.deleted = true;
+      changed = true;
+      ++i;
+      continue;
+    }
+    if (a_const && (b.opcode == TEST_JUMP_IF_FALSE ||
+                    b.opcode == TEST_JUMP_IF_TRUE)) {
+      // Constant condition: either always or never jumps.
+      bool taken = (b.opcode == TEST_JUMP_IF_FALSE) == (ca == 0);
+      if (taken) {
+        a.opcode = JUMP;
+        a.target = b.target;
+      } else {
+        a.deleted = true;
+      }
+      b.deleted = true;
+      changed = true;
+      ++i;
+      continue;
+    }
+    if ((a_const || a.opcode == PUSH_TOP) && b.opcode == POP_OP) {
+      a.deleted = true;
+      b.deleted = true;
+      changed = true;
+      ++i;
+      continue;
+    }
+    if (a.opcode == BOOL_NOT && (b.opcode == TEST_JUMP_IF_FALSE ||
+                                 b.opcode == TEST_JUMP_IF_TRUE)) {
+      a.opcode = b.opcode == TEST_JUMP_IF_FALSE ? TEST_JUMP_IF_TRUE
+                                                : TEST_JUMP_IF_FALSE;
+      a.target = b.target;
+      b.deleted = true;
+      changed = true;
+      ++i;
+      continue;
+    }
+    if (a.opcode == BOOL_NOT && b.opcode == BOOL_NOT) {
+      a.opcode = BOOL_PROJECT;
+      b.deleted = true;
+      changed = true;
+      ++i;
+      continue;
+    }
+    if (a.opcode == BOOL_PROJECT &&
+        (b.opcode == TEST_JUMP_IF_FALSE || b.opcode == TEST_JUMP_IF_TRUE ||
+         b.opcode == BOOL_NOT || b.opcode == BOOL_PROJECT)) {
+      // The next instruction only looks at zero vs non-zero anyway.
+      a.deleted = true;
+      changed = true;
+      continue;
+    }
+    if (i + 2 >= n || is_target(i + 2)) continue;
+    Insn& c = insns_[i + 2];
+    if (a_const && get_constant(b, &cb) &&
+        fold_binary(c.opcode, ca, cb, &result)) {
+      set_constant(&a, result);
+      b.deleted = true;
+      c.deleted = true;
+      changed = true;
+      i += 2;
+      continue;
+    }
+    if (a.opcode == PUSH_TOP &&
+        (b.opcode == TEST_JUMP_IF_FALSE || b.opcode == TEST_JUMP_IF_TRUE) &&
+        c.opcode == POP_OP && b.target < (int)n) {
+      // Short-circuit && and || feeding into a branch: when the jump is
+      // taken we know the value at the target. If the target is a
+      // conditional jump too, we can go directly to where that one goes.
+      const Insn& t = insns_[b.target];
+      bool value = b.opcode == TEST_JUMP_IF_TRUE;
+      bool t_taken = (t.opcode == TEST_JUMP_IF_TRUE) == value;
+      int new_target = t_taken ? t.target : b.target + 1;
+      // A new jump target must not have been merged into a previous
+      // instruction in this pass already.
+      bool target_ok =
+          t_taken || is_target(new_target) || new_target > (int)i + 2;
+      if (!t.deleted &&
+          (t.opcode == TEST_JUMP_IF_FALSE || t.opcode == TEST_JUMP_IF_TRUE) &&
+          target_ok) {
+        is_target_[new_target] = true;
+        a.opcode = b.opcode;
+        a.target = new_target;
+        b.deleted = true;
+        c.deleted = true;
+        changed = true;
+        i += 2;
+        continue;
+      }
+    }
+  }
+  return changed;
+}
+
+bool BytecodeOptimizer::thread_jumps() {
+  bool changed = false;
+  int n = insns_.size();
+  for (auto& insn : insns_) {
+    if (!is_jump(insn)) continue;
+    for (unsigned k = 0; k < MAX_JUMP_CHAIN && insn.target < n; ++k) {
+      const Insn& t = insns_[insn.target];
+      if (t.opcode != JUMP || t.target == insn.target) break;
+      insn.target = t.target;
+      changed = true;
+    }
+    if (insn.opcode == JUMP && insn.target < n) {
+      // A jump to a terminate or return can be replaced by that instruction.
+      OpCode t = insns_[insn.target].opcode;
+      if (t == TERMINATE || t == RET) {
+        insn.opcode = t;
+        insn.target = -1;
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+bool BytecodeOptimizer::remove_dead_code() {
+  unsigned n = insns_.size();
+  std::vector<bool> reachable(n + 1, false);
+  std::vector<unsigned> todo;
+  todo.push_back(0);
+  for (const auto& insn : insns_) {
+    if (!is_jump(insn) && insn.target >= 0) {
+      // Function entry.
+      todo.push_back(insn.target);
+    }
+  }
+  while (!todo.empty()) {
+    unsigned i = todo.back();
+    todo.pop_back();
+    if (reachable[i]) continue;
+    reachable[i] = true;
+    if (i == n) continue;
+    const Insn& insn = insns_[i];
+    if (is_jump(insn)) {
+      todo.push_back(insn.target);
+    }
+    if (insn.opcode != JUMP && insn.opcode != TERMINATE &&
+        insn.opcode != RET) {
+      todo.push_back(i + 1);
+    }
+  }
+  bool changed = false;
+  for (unsigned i = 0; i < n; ++i) {
+    if (!reachable[i]) {
+      insns_[i].deleted = true;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+} // namespace logic
@@ -0,0 +1,178 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Optimizer.hxx
+ *
+ * Optimizing pass that runs on the compiled bytecode before it is handed to
+ * the VM.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#ifndef _LOGIC_OPTIMIZER_HXX_
+#define _LOGIC_OPTIMIZER_HXX_
+
+#include <string>
+#include <vector>
+
+#include "logic/Bytecode.hxx"
+
+namespace logic {
+
+/// Rewrites a piece of bytecode into a shorter but equivalent one. Performs
+/// constant folding, elimination of constant branches, jump threading,
+/// peephole rewrites and removal of unreachable code.
+///
+/// The bytecode is decoded into an instruction list where jump and call
+/// targets are instruction indexes, the passes run on that list, and then
+/// the offsets are recomputed when encoding back.
+class BytecodeOptimizer {
+ public:
+  /// Optimizes a piece of bytecode.
+  /// @param code is the bytecode to optimize. It is replaced with the
+  /// optimized bytecode. Left unchanged if it contains something the
+  /// optimizer does not understand (e.g. a jump into the middle of an
+  /// instruction).
+  /// @param base_ofs is the offset of code[0] inside the block's bytecode. Used
+  /// to relocate the absolute call addresses.
+  /// @param lines if not null, the SOURCE_LINE instructions are turned into
+  /// entries appended here (with offsets including base_ofs).
+  /// @return true if the code was optimized. If false, nothing was appended
+  /// to lines.
+  static bool optimize(std::string* code, unsigned base_ofs = 0,
+                       SourceLineTable* lines = nullptr);
+
+  /// Creates the source line table of a bytecode that still contains the
+  /// SOURCE_LINE instructions (e.g. because it was not optimized).
+  /// @param code is the bytecode.
+  /// @param base_ofs is the offset of code[0] inside the block's bytecode.
+  /// @param lines the entries will be appended here.
+  static void collect_source_lines(const std::string& code, unsigned base_ofs,
+                                   SourceLineTable* lines);
+
+ private:
+  /// Describes what operand bytes follow an opcode.
+  enum OperandFormat {
+    /// No operands.
+    OPERAND_NONE,
+    /// A single varint.
+    OPERAND_VARINT,
+    /// Two varints.
+    OPERAND_TWO_VARINTS,
+    /// A varint length followed by that many bytes.
+    OPERAND_STRING,
+    /// Not known to the optimizer.
+    OPERAND_UNKNOWN,
+  };
+
+  /// One decoded instruction.
+  struct Insn {
+    OpCode opcode;
+    /// First varint argument, or the value of a constant push.
+    int arg{0};
+    /// Second varint argument. For call addresses the upper (block number)
+    /// bits of the address.
+    int arg2{0};
+    /// Argument of LOAD_STRING.
+    std::string str;
+    /// For jumps: the index of the target instruction. For a constant push
+    /// that is the address of a CALL: the index of the function entry. -1
+    /// otherwise. Index insns_.size() is the end of the code.
+    int target{-1};
+    /// True if this instruction is removed in the current pass.
+    bool deleted{false};
+    /// Source line this instruction was generated from, 0 if unknown.
+    unsigned line{0};
+  };
+
+  BytecodeOptimizer(unsigned base_ofs) : base_ofs_(base_ofs) {}
+
+  /// @return the operand layout of an opcode.
+  static OperandFormat operand_format(OpCode opcode);
+
+  /// Fills in insns_ from a piece of bytecode.
+  /// @return false if the bytecode cannot be optimized.
+  bool decode(const std::string& code);
+
+  /// Renders insns_ into bytecode.
+  /// @param lines if not null, the source line table is appended here.
+  /// @return false if the offsets could not be computed.
+  bool encode(std::string* output, SourceLineTable* lines);
+
+  /// Removes the SOURCE_LINE instructions and puts their line number into
+  /// the following instructions.
+  void strip_source_lines();
+
+  /// @return true if insn is a jump (conditional or not).
+  static bool is_jump(const Insn& insn);
+
+  /// @return true if insn pushes a constant value (which is not a call
+  /// address). Fills in *value.
+  static bool get_constant(const Insn& insn, int* value);
+
+  /// Replaces an instruction with a constant push.
+  static void set_constant(Insn* insn, int value);
+
+  /// Computes the result of a binary operator on constants.
+  /// @return false if the operation cannot be folded (e.g. division by zero,
+  /// which has to stay a runtime error).
+  static bool fold_binary(OpCode opcode, int lhs, int rhs, int* result);
+
+  /// @return true if instruction idx is the target of a jump or call.
+  bool is_target(unsigned idx) {
+    return idx < is_target_.size() && is_target_[idx];
+  }
+
+  /// Marks which instructions are jump targets.
+  void compute_targets();
+
+  /// Removes the deleted instructions and updates the targets.
+  void compact();
+
+  /// Runs the peephole rewrites (constant folding, constant branches, branch
+  /// simplifications). @return true if anything changed.
+  bool peephole();
+
+  /// Retargets jumps that land on unconditional jumps. @return true if
+  /// anything changed.
+  bool thread_jumps();
+
+  /// Deletes the instructions that cannot be reached from the entry or any
+  /// function. @return true if anything changed.
+  bool remove_dead_code();
+
+  /// Offset of the code in the block.
+  unsigned base_ofs_;
+  /// The decoded instructions.
+  std::vector<Insn> insns_;
+  /// One entry for each instruction, true if it is a jump or call target.
+  std::vector<bool> is_target_;
+};
+
+} // namespace logic
+
+#endif // _LOGIC_OPTIMIZER_HXX_
@@ -237,6 +237,11 @@ storage_specifier type_specifier "undeclared_identifier" variable_parameters opt
   }
   driver.decl_helper_.emplace_back(std::move(cmd));
 } multi_variable_decl optional_semicolon {
+  if (@1.begin.line == @1.end.line && @1.begin.column == @1.end.column) {
+    // The storage specifier was empty; its location is the end of the
+    // previous token.
+    @$.begin = @2.begin;
+  }
   if (driver.decl_helper_.size() > 1) {
     $$ = std::make_shared<CommandSequence>(std::move(driver.decl_helper_));
   } else {
@@ -383,6 +388,9 @@ assignment optional_semicolon { $$ = std::move($1); };
 commands:
 %empty { $$ = std::make_shared<std::vector<std::shared_ptr<Command>>>(); }
 | commands command {
+  if (driver.line_info()) {
+    $1->push_back(std::make_shared<SourceLine>(@2.begin.line));
+  }
   $1->push_back(std::move($2));
   $$ = std::move($1);
 };
@@ -38,32 +38,32 @@
 
 #include "logic/Runner.hxx"
 
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "logic/Driver.hxx"
+#include "logic/NativeBlock.hxx"
 #include "logic/VM.hxx"
-#include "utils/FileUtils.hxx"
 #include "executor/Executor.hxx"
 #include "logic/OlcbBindingsConfig.hxx"
 #include "logic/OlcbBindings.hxx"
-
-#ifdef __linux__
-#include "os/TempFile.hxx"
-
-TempFile compile_tmp(*TempDir::instance(), "compile");
-
-#elif defined(__FreeRTOS__)
-#include "freertos_drivers/common/RamDisk.hxx"
-RamDisk* rdisk = nullptr;
-
-#else
-#error dont know how to make temp files
-
-#endif
+#include "os/os.h"
 
 namespace logic {
 
 /// Logic should run 10 times a second.
 constexpr long AUTOMATA_TICK_MSEC = 100;
-constexpr unsigned MAX_SOURCE_SIZE = 2050;
+/// Blocks that had no input change are still executed this often.
+constexpr long BLOCK_REFRESH_MSEC = 1000;
+/// How many instructions are executed between two samples of the profiler.
+/// A prime to avoid aliasing with loops in the logic code.
+constexpr unsigned PROFILE_SAMPLE_PERIOD = 61;
 
 class RunnerTimer : public ::Timer {
  public:
@@ -79,34 +79,169 @@ class RunnerTimer : public ::Timer {
   Runner* parent_;
 };
 
+/// Marks the beginning of the bytecode cache file.
+static constexpr uint32_t CACHE_MAGIC = 0x4C474243;  // "LGBC"
+
+struct CachedBlock {
+  /// Hash of the block number and source code this bytecode was compiled
+  /// from.
+  uint32_t hash{0};
+  /// Size of the bytecode before optimization (for the status string).
+  uint32_t unoptimized_size{0};
+  /// Compiled bytecode. Empty if this entry is not valid.
+  std::string bytecode;
+  /// Source line table of the bytecode.
+  SourceLineTable lines;
+};
+
 struct BlockInfo {
   /// true if the block is operational
   bool enabled;
+  /// os_get_time_monotonic() when this block was last executed.
+  long long last_run{0};
+  /// Source line table of the compiled code.
+  SourceLineTable lines;
+  /// Execution statistics. Protected by RunnerImpl::lock_.
+  Runner::BlockProfile profile;
+  /// True if the block has to be executed in the current step.
+  bool run_pending{false};
+  /// Error message from executing the block in the current step. Empty if
+  /// there was no error.
+  std::string run_error;
+  /// Hash of the source and the variable bindings of the code loaded into
+  /// the VM. Valid only if enabled is true.
+  uint32_t loaded_hash{0};
+};
+
+/// A thread with its own virtual machine, which executes a subset of the
+/// logic blocks in parallel mode.
+struct RunnerWorker {
+  RunnerWorker(VariableFactory* vars) : vm_(vars) {}
+
+  /// Execution engine. Owns the variables of the blocks of this worker.
+  VM vm_;
+  /// Thread context where the blocks of this worker are executed.
+  Executor<1> thread_{"logic_worker", 0, 3000};
 };
 
 struct Runner::RunnerImpl {
   RunnerImpl(VariableFactory* vars, Runner* parent)
       : parent_(parent), vm_(vars) {
+    compile_driver_.set_line_info(true);
+    vm_.set_ip_sampler(PROFILE_SAMPLE_PERIOD,
+                       std::bind(&RunnerImpl::sample, this,
+                                 std::placeholders::_1));
   }
 
   ~RunnerImpl();
   
   Runner* parent_;
 
+  /// @param block_num is the index of the logic block.
+  /// @return the virtual machine which owns the code and variables of a
+  /// block.
+  VM* vm_for(unsigned block_num) {
+    if (workers_.empty()) return &vm_;
+    return &workers_[block_num % workers_.size()]->vm_;
+  }
+
+  /// Executes a logic block once. Errors are stored in the block's
+  /// run_error. Called on the logic thread or in parallel mode on the
+  /// thread of the worker owning the block.
+  /// @param block_num is the index of the logic block.
+  void run_block(unsigned block_num);
+
+  /// Executes the pending blocks of a worker. Called on the worker's thread.
+  /// @param worker_idx is the index of the worker in workers_.
+  void run_worker(unsigned worker_idx);
+
   /// Compilation engine.
   Driver compile_driver_;
   
-  /// Execution engine.
+  /// Execution engine. Used only when there are no workers.
   VM vm_;
 
+  /// Worker threads for parallel execution. Empty if the blocks are executed
+  /// on the logic thread.
+  std::vector<std::unique_ptr<RunnerWorker>> workers_;
+
   /// Thread context in which all the operations take place.
   Executor<1> automata_thread_{"logic", 0, 3000};
 
   /// Responsible for repeated execution of the automata tick.
   RunnerTimer* timer_{nullptr};
 
+  /// Protects running_, wakeup_pending_ and the block profiles.
+  Atomic lock_;
+  /// True if the periodic execution is on.
+  bool running_{false};
+  /// True if there is a wakeup callback in the executor queue.
+  bool wakeup_pending_{false};
+
+  /// True while single_step() is executing blocks. Instruction samples are
+  /// only taken then.
+  bool stepping_{false};
+
   /// Stores information on a per-block basis: compiled bytecode for example.
   BlockInfo logic_blocks_[LogicConfig(0).blocks().num_repeats()];
+
+  /// Instruction sampler callback from the VM. Attributes the sample to the
+  /// source line of the IP.
+  /// @param ip is the IP of the instruction being executed.
+  void sample(VM::ip_t ip);
+
+  /// Adds one execution of a block to its profile.
+  /// @param block_num is the index of the logic block.
+  /// @param nsec is the execution time.
+  /// @param insns is the number of instructions executed.
+  /// @param reads is the number of external variable reads.
+  /// @param writes is the number of external variable writes.
+  void record_execution(unsigned block_num, long long nsec, uint64_t insns,
+                        unsigned reads, unsigned writes);
+
+  /// Clears the profile of a block and sets the source line table for new
+  /// code.
+  /// @param block_num is the index of the logic block.
+  /// @param lines is the source line table of the new code.
+  void reset_profile(unsigned block_num, SourceLineTable lines);
+
+  /// Computes the cache key of a block.
+  /// @param block_num is the index of the logic block.
+  /// @param source is the source code of the block.
+  /// @return the hash (FNV-1a) of the block number and the source.
+  static uint32_t source_hash(unsigned block_num, const std::string& source);
+
+  /// Computes the key that tells whether a loaded block has to be compiled
+  /// again.
+  /// @param source_hash is the result of source_hash() for the block.
+  /// @param body is the configuration of the block.
+  /// @param fd is the configuration file descriptor.
+  /// @return source_hash extended with the names and events of the imported
+  /// variables.
+  static uint32_t binding_hash(uint32_t source_hash,
+                               const LogicBlockBody& body, int fd);
+
+  /// Loads cache_ from cache_file_. Invalid or missing files leave the cache
+  /// empty.
+  void load_cache();
+
+  /// Writes cache_ to cache_file_, replacing the file only if the whole cache
+  /// could be written.
+  void save_cache();
+
+  /// Path of the bytecode cache file. Empty if caching is off.
+  std::string cache_file_;
+  /// True if cache_file_ was already read.
+  bool cache_loaded_{false};
+  /// True if cache_ has changed since it was loaded or saved.
+  bool cache_dirty_{false};
+  /// Compiled bytecode for each block.
+  CachedBlock cache_[LogicConfig(0).blocks().num_repeats()];
+
+  /// Path of the shared object with translated blocks. Empty if none.
+  std::string native_library_;
+  /// True if native_library_ was already loaded.
+  bool native_loaded_{false};
 };
 
 Runner::Runner(OlcbVariableFactory* vars)
@@ -117,43 +252,413 @@ Runner::~Runner() {
   while (!impl()->automata_thread_.active_timers()->empty()) {
     usleep(20000);
   }
+  while (true) {
+    {
+      AtomicHolder h(&impl()->lock_);
+      if (!impl()->wakeup_pending_) break;
+    }
+    usleep(20000);
+  }
   delete impl_;
 }
 
 Runner::RunnerImpl::~RunnerImpl() {
 }
 
+/// Adds data to an FNV-1a hash.
+/// @param h is the hash to update.
+/// @param data is the data to add.
+/// @param len is the number of bytes in data.
+static void fnv_add(uint32_t* h, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < len; ++i) {
+    *h ^= p[i];
+    *h *= 16777619u;
+  }
+}
+
+// static
+uint32_t Runner::RunnerImpl::source_hash(unsigned block_num,
+                                         const std::string& source) {
+  uint32_t h = 2166136261u;
+  for (unsigned i = 0; i < 4; ++i) {
+    uint8_t b = (block_num >> (8 * i)) & 0xff;
+    fnv_add(&h, &b, 1);
+  }
+  fnv_add(&h, source.data(), source.size());
+  return h;
+}
+
+// static
+uint32_t Runner::RunnerImpl::binding_hash(uint32_t source_hash,
+                                          const LogicBlockBody& body, int fd) {
+  uint32_t h = source_hash;
+  for (unsigned i = 0; i < body.imports().num_repeats(); ++i) {
+    const auto& e = body.imports().entry(i);
+    std::string name = e.name().read(fd);
+    // The terminating zero separates the name from the events.
+    fnv_add(&h, name.c_str(), name.size() + 1);
+    uint64_t events[2] = {e.event_on().read(fd), e.event_off().read(fd)};
+    fnv_add(&h, events, sizeof(events));
+  }
+  return h;
+}
+
+/// Reads a 32-bit value from a buffer.
+/// @param p is the read pointer, will be advanced.
+/// @param eof is the end of the buffer.
+/// @param value will be filled in.
+/// @return false if there were not enough bytes.
+static bool read_u32(const char** p, const char* eof, uint32_t* value) {
+  if (eof - *p < (int)sizeof(*value)) return false;
+  memcpy(value, *p, sizeof(*value));
+  *p += sizeof(*value);
+  return true;
+}
+
+/// Appends a 32-bit value to a buffer.
+static void append_u32(std::string* output, uint32_t value) {
+  output->append((const char*)&value, sizeof(value));
+}
+
+void Runner::RunnerImpl::load_cache() {
+  cache_loaded_ = true;
+  int fd = ::open(cache_file_.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  std::string data;
+  char buf[256];
+  ssize_t len;
+  while ((len = ::read(fd, buf, sizeof(buf))) > 0) {
+    data.append(buf, len);
+  }
+  ::close(fd);
+  const char* p = data.data();
+  const char* eof = p + data.size();
+  uint32_t magic, version, count;
+  if (!read_u32(&p, eof, &magic) || magic != CACHE_MAGIC ||
+      !read_u32(&p, eof, &version) || version != Driver::COMPILER_VERSION ||
+      !read_u32(&p, eof, &count) || count != ARRAYSIZE(cache_)) {
+    LOG(INFO, "Logic bytecode cache %s is invalid.", cache_file_.c_str());
+    return;
+  }
+  CachedBlock blocks[ARRAYSIZE(cache_)];
+  for (auto& b : blocks) {
+    uint32_t size;
+    if (!read_u32(&p, eof, &b.hash) ||
+        !read_u32(&p, eof, &b.unoptimized_size) ||
+        !read_u32(&p, eof, &size) || (uint32_t)(eof - p) < size) {
+      LOG(INFO, "Logic bytecode cache %s is truncated.", cache_file_.c_str());
+      return;
+    }
+    b.bytecode.assign(p, size);
+    p += size;
+    uint32_t num_lines;
+    if (!read_u32(&p, eof, &num_lines) ||
+        (uint32_t)(eof - p) / (2 * sizeof(uint32_t)) < num_lines) {
+      LOG(INFO, "Logic bytecode cache %s is truncated.", cache_file_.c_str());
+      return;
+    }
+    b.lines.resize(num_lines);
+    for (auto& e : b.lines) {
+      uint32_t ofs, line;
+      read_u32(&p, eof, &ofs);
+      read_u32(&p, eof, &line);
+      e.offset = ofs;
+      e.line = line;
+    }
+  }
+  for (unsigned i = 0; i < ARRAYSIZE(cache_); ++i) {
+    cache_[i] = std::move(blocks[i]);
+  }
+}
+
+void Runner::RunnerImpl::save_cache() {
+  std::string data;
+  append_u32(&data, CACHE_MAGIC);
+  append_u32(&data, Driver::COMPILER_VERSION);
+  append_u32(&data, ARRAYSIZE(cache_));
+  for (const auto& b : cache_) {
+    append_u32(&data, b.hash);
+    append_u32(&data, b.unoptimized_size);
+    append_u32(&data, b.bytecode.size());
+    data.append(b.bytecode);
+    append_u32(&data, b.lines.size());
+    for (const auto& e : b.lines) {
+      append_u32(&data, e.offset);
+      append_u32(&data, e.line);
+    }
+  }
+  // A failed save is not retried until the next compilation changes the
+  // cache again.
+  cache_dirty_ = false;
+  // Writes a temporary file first, so that a failed write never leaves a
+  // truncated cache behind.
+  std::string tmp_file = cache_file_ + ".tmp";
+  int fd = ::open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG(WARNING, "Could not open logic bytecode cache %s.", tmp_file.c_str());
+    return;
+  }
+  const char* p = data.data();
+  size_t left = data.size();
+  while (left) {
+    ssize_t len = ::write(fd, p, left);
+    if (len <= 0) {
+      break;
+    }
+    p += len;
+    left -= len;
+  }
+  if (::close(fd) != 0 || left) {
+    LOG(WARNING, "Error writing logic bytecode cache %s.", tmp_file.c_str());
+    ::unlink(tmp_file.c_str());
+    return;
+  }
+  if (::rename(tmp_file.c_str(), cache_file_.c_str()) != 0) {
+    LOG(WARNING, "Could not replace logic bytecode cache %s.",
+        cache_file_.c_str());
+    ::unlink(tmp_file.c_str());
+  }
+}
+
+void Runner::RunnerImpl::sample(VM::ip_t ip) {
+  if (!stepping_) return;
+  unsigned block_num = VM::ip_block_num(ip);
+  if (block_num >= ARRAYSIZE(logic_blocks_)) return;
+  auto* bi = logic_blocks_ + block_num;
+  unsigned ofs = VM::ip_offset(ip);
+  auto it = std::upper_bound(
+      bi->lines.begin(), bi->lines.end(), ofs,
+      [](unsigned o, const SourceLineEntry& e) { return o < e.offset; });
+  unsigned line = it == bi->lines.begin() ? 0 : (it - 1)->line;
+  AtomicHolder h(&lock_);
+  auto& p = bi->profile;
+  ++p.samples;
+  // Keeps the top lines with the space-saving algorithm: a line not yet
+  // tracked replaces the one with the fewest samples.
+  auto* min_slot = &p.hot_lines[0];
+  for (auto& hl : p.hot_lines) {
+    if (hl.count && hl.line == line) {
+      ++hl.count;
+      return;
+    }
+    if (hl.count < min_slot->count) min_slot = &hl;
+  }
+  min_slot->line = line;
+  ++min_slot->count;
+}
+
+void Runner::RunnerImpl::record_execution(unsigned block_num, long long nsec,
+                                          uint64_t insns, unsigned reads,
+                                          unsigned writes) {
+  AtomicHolder h(&lock_);
+  auto& p = logic_blocks_[block_num].profile;
+  if (!p.executions || nsec < p.min_nsec) p.min_nsec = nsec;
+  if (nsec > p.max_nsec) p.max_nsec = nsec;
+  ++p.executions;
+  p.total_nsec += nsec;
+  p.insns += insns;
+  p.reads += reads;
+  p.writes += writes;
+}
+
+void Runner::RunnerImpl::reset_profile(unsigned block_num,
+                                       SourceLineTable lines) {
+  logic_blocks_[block_num].lines = std::move(lines);
+  AtomicHolder h(&lock_);
+  logic_blocks_[block_num].profile = Runner::BlockProfile();
+}
+
+Runner::BlockProfile Runner::get_profile(unsigned block_num) {
+  BlockProfile ret;
+  if (block_num >= ARRAYSIZE(impl()->logic_blocks_)) return ret;
+  AtomicHolder h(&impl()->lock_);
+  ret = impl()->logic_blocks_[block_num].profile;
+  return ret;
+}
+
+std::string Runner::profile_report(unsigned block_num) {
+  BlockProfile p = get_profile(block_num);
+  if (!p.executions) {
+    return "Not run since last compile.";
+  }
+  std::string ret = StringPrintf(
+      "Runs: %u\nTime usec avg/min/max: %u/%u/%u\nInstructions avg: "
+      "%u\nExternal reads: %u writes: %u\n",
+      (unsigned)p.executions, (unsigned)(p.total_nsec / p.executions / 1000),
+      (unsigned)(p.min_nsec / 1000), (unsigned)(p.max_nsec / 1000),
+      (unsigned)(p.insns / p.executions), (unsigned)p.reads,
+      (unsigned)p.writes);
+  if (!p.samples) {
+    return ret;
+  }
+  std::sort(std::begin(p.hot_lines), std::end(p.hot_lines),
+            [](const HotLine& a, const HotLine& b) {
+              return a.count > b.count;
+            });
+  ret += StringPrintf("Hot lines of %u samples:", (unsigned)p.samples);
+  for (const auto& hl : p.hot_lines) {
+    if (!hl.count) break;
+    if (hl.line) {
+      ret += StringPrintf(" %u", (unsigned)hl.line);
+    } else {
+      ret += " ?";
+    }
+    ret += StringPrintf(":%u%%", (unsigned)(hl.count * 100 / p.samples));
+  }
+  return ret;
+}
+
+void Runner::set_worker_threads(unsigned count) {
+  HASSERT(impl()->workers_.empty());
+  if (count < 2) return;
+  for (unsigned i = 0; i < count; ++i) {
+    auto* w = new RunnerWorker(variable_factory_);
+    w->vm_.set_ip_sampler(PROFILE_SAMPLE_PERIOD,
+                          std::bind(&RunnerImpl::sample, impl(),
+                                    std::placeholders::_1));
+    impl()->workers_.emplace_back(w);
+  }
+  // Each worker gets the access errors of its own blocks. They end up in the
+  // run_error of the block, which is reported in block order after the step.
+  for (unsigned i = 0; i < ARRAYSIZE(impl()->logic_blocks_); ++i) {
+    impl()->vm_for(i)->route_access_errors(i);
+  }
+}
+
+void Runner::set_native_library(std::string filename) {
+  impl()->native_library_ = std::move(filename);
+  impl()->native_loaded_ = false;
+}
+
+void Runner::set_cache_file(std::string filename) {
+  impl()->cache_file_ = std::move(filename);
+  impl()->cache_loaded_ = false;
+}
+
 void Runner::start_running() {
   HASSERT(!impl()->timer_);
   impl()->timer_ = new RunnerTimer(&impl()->automata_thread_, this);
   impl()->timer_->start(MSEC_TO_NSEC(AUTOMATA_TICK_MSEC));
+  AtomicHolder h(&impl()->lock_);
+  impl()->running_ = true;
 }
 
 void Runner::stop_running() {
   if (!impl()->timer_) return; // nothing to stop
+  {
+    AtomicHolder h(&impl()->lock_);
+    impl()->running_ = false;
+  }
   // Signals the timer to stop running. Will prevent all further callbacks.
   impl()->timer_->parent_ = nullptr;
   impl()->timer_ = nullptr;
 }
 
+void Runner::wakeup() {
+  {
+    AtomicHolder h(&impl()->lock_);
+    if (!impl()->running_ || impl()->wakeup_pending_) return;
+    impl()->wakeup_pending_ = true;
+  }
+  impl()->automata_thread_.add(new CallbackExecutable([this]() {
+    bool running;
+    {
+      AtomicHolder h(&impl()->lock_);
+      impl()->wakeup_pending_ = false;
+      running = impl()->running_;
+    }
+    if (running) single_step();
+  }));
+}
+
+void Runner::RunnerImpl::run_block(unsigned block_num) {
+  auto* bi = logic_blocks_ + block_num;
+  VM* vm = vm_for(block_num);
+  vm->clear();
+  vm->set_preamble(false);
+  vm->set_block_num(block_num);
+  uint64_t insns = vm->insns_retired();
+  unsigned reads = vm->external_reads();
+  unsigned writes = vm->external_writes();
+  long long start = os_get_time_monotonic();
+  bool ok = vm->execute_block(block_num);
+  long long end = os_get_time_monotonic();
+  record_execution(block_num, end - start, vm->insns_retired() - insns,
+                   vm->external_reads() - reads,
+                   vm->external_writes() - writes);
+  if (!ok) {
+    bi->run_error = "Error in running: " + vm->get_error();
+  }
+}
+
+void Runner::RunnerImpl::run_worker(unsigned worker_idx) {
+  for (unsigned i = worker_idx; i < ARRAYSIZE(logic_blocks_);
+       i += workers_.size()) {
+    if (logic_blocks_[i].run_pending) {
+      run_block(i);
+    }
+  }
+}
+
 void Runner::single_step() {
-  for (unsigned i = 0; i < variable_factory_->cfg().blocks().num_repeats();
-       ++i) {
+  uint32_t changed = variable_factory_->take_changed_blocks();
+  long long now = os_get_time_monotonic();
+  unsigned num_blocks = variable_factory_->cfg().blocks().num_repeats();
+  for (unsigned i = 0; i < num_blocks; ++i) {
     auto* bi = impl()->logic_blocks_ + i;
-    if (!bi->enabled) continue;
-    impl()->vm_.clear();
-    impl()->vm_.set_preamble(false);
-    impl()->vm_.set_block_num(i);
-    if (!impl()->vm_.execute_block(i)) {
-      std::string status = "Error in running: " + impl()->vm_.get_error();
-      int fd = variable_factory_->fd();
-      const auto& bl = variable_factory_->cfg().blocks().entry(i);
-      bi->enabled = false;
-      if (status != bl.body().status().read(fd)) {
-        bl.body().status().write(fd, status);
-      }
+    // Only those blocks run that had an input change or are due for a
+    // refresh.
+    bi->run_pending =
+        bi->enabled && ((changed & VariableFactory::block_bit(i)) != 0 ||
+                        now - bi->last_run >= MSEC_TO_NSEC(BLOCK_REFRESH_MSEC));
+    if (bi->run_pending) {
+      bi->last_run = now;
+    }
+  }
+  variable_factory_->begin_write_batch();
+  impl()->stepping_ = true;
+  if (impl()->workers_.empty()) {
+    // Event reports from variable writes are collected and go out in block
+    // order after the last block, same as with the workers. Another block
+    // sees a write through a shared event only in the next step, so the
+    // result does not depend on how fast the loopback is.
+    for (unsigned i = 0; i < num_blocks; ++i) {
+      if (!impl()->logic_blocks_[i].run_pending) continue;
+      impl()->run_block(i);
     }
+    variable_factory_->send_write_batch();
+  } else {
+    // The workers run concurrently. The event reports are collected per
+    // block and go out in block order when all workers are done, so the
+    // output does not depend on the thread scheduling.
+    SyncNotifiable sn;
+    BarrierNotifiable bn(&sn);
+    for (unsigned w = 0; w < impl()->workers_.size(); ++w) {
+      Notifiable* done = bn.new_child();
+      impl()->workers_[w]->thread_.add(
+          new CallbackExecutable([this, w, done]() {
+            AutoNotify an(done);
+            impl()->run_worker(w);
+          }));
+    }
+    bn.notify();
+    sn.wait_for_notification();
+    variable_factory_->send_write_batch();
   }
+  impl()->stepping_ = false;
+  for (unsigned i = 0; i < num_blocks; ++i) {
+    auto* bi = impl()->logic_blocks_ + i;
+    if (bi->run_error.empty()) continue;
+    int fd = variable_factory_->fd();
+    const auto& bl = variable_factory_->cfg().blocks().entry(i);
+    bi->enabled = false;
+    if (bi->run_error != bl.body().status().read(fd)) {
+      bl.body().status().write(fd, bi->run_error);
+    }
+    bi->run_error.clear();
+  }
+  variable_factory_->end_write_batch();
 }
 
 void Runner::compile(Notifiable* done) {
@@ -163,63 +668,115 @@ void Runner::compile(Notifiable* done) {
 
 void Runner::compile_impl(Notifiable* done) {
   AutoNotify an(done);
-  string tempfilename;
-#ifdef __FreeRTOS__
-  tempfilename = "/tmp/compile";
-  if (!rdisk) {
-    rdisk = new RamDisk(tempfilename.c_str(), MAX_SOURCE_SIZE);
-  }
-#else
-  tempfilename = compile_tmp.name();
-#endif
   while (!variable_factory_->node()->is_initialized()) {
     usleep(20000);
   }
   
+  if (!impl()->cache_file_.empty() && !impl()->cache_loaded_) {
+    impl()->load_cache();
+  }
+  if (!impl()->native_library_.empty() && !impl()->native_loaded_) {
+    impl()->native_loaded_ = true;
+    std::string error;
+    if (!load_native_library(impl()->native_library_, &error)) {
+      LOG(WARNING, "Could not load native logic blocks from %s: %s",
+          impl()->native_library_.c_str(), error.c_str());
+    }
+  }
+
   int fd = variable_factory_->fd();
+  // The identify queries of all newly created variables are sent in one
+  // pipelined burst instead of one round trip per event.
+  variable_factory_->begin_write_batch();
   for (unsigned i = 0; i < variable_factory_->cfg().blocks().num_repeats();
        ++i) {
     auto* bi = impl()->logic_blocks_ + i;
     const auto& bl = variable_factory_->cfg().blocks().entry(i);
     
     std::string source = bl.body().text().read(fd);
-    source.push_back(0);
-    write_string_to_file(tempfilename, source);
     std::string status;
-    impl()->compile_driver_.clear();
-    impl()->compile_driver_.set_guid_start(i << 16);
-    if (impl()->compile_driver_.parse_file(tempfilename) != 0) {
-      status = "Compile failed.\n";
-      status += impl()->compile_driver_.error_output_;
-      bi->enabled = false;
-    } else {
+    uint32_t hash = RunnerImpl::source_hash(i, source);
+    bool enabled = CDI_READ_TRIMMED(bl.enabled, fd);
+    if (enabled && bi->enabled &&
+        bi->loaded_hash == RunnerImpl::binding_hash(hash, bl.body(), fd)) {
+      // Nothing changed about this block. It keeps its variables and their
+      // state, so it causes no network traffic and its outputs do not
+      // glitch.
+      continue;
+    }
+    auto* cached = impl()->cache_ + i;
+    VM* vm = impl()->vm_for(i);
+    bool from_cache = !cached->bytecode.empty() && cached->hash == hash;
+    bool compiled = from_cache;
+    impl()->reset_profile(i, SourceLineTable());
+    if (!from_cache) {
+      impl()->compile_driver_.clear();
+      impl()->compile_driver_.set_guid_start(i << 16);
+      if (impl()->compile_driver_.parse_string(source) != 0) {
+        status = "Compile failed.\n";
+        status += impl()->compile_driver_.error_output_;
+        bi->enabled = false;
+      } else {
+        compiled = true;
+      }
+    }
+    if (compiled) {
       status = "Compile OK. ";
-      bi->enabled = CDI_READ_TRIMMED(bl.enabled, fd);
+      bi->enabled = enabled;
       if (!bi->enabled) {
         status += "Disabled.";
-        impl()->vm_.save_variables(i<<16, (i+1)<<16);
-        impl()->vm_.destroy_saved_variables();
+        vm->save_variables(i<<16, (i+1)<<16);
+        vm->destroy_saved_variables();
       }
     }
     if (bi->enabled) {
       std::string bc;
-      impl()->compile_driver_.serialize(&bc);
-      impl()->vm_.clear();
+      if (from_cache) {
+        bc = cached->bytecode;
+      } else {
+        impl()->compile_driver_.serialize(&bc);
+        cached->hash = hash;
+        cached->unoptimized_size = impl()->compile_driver_.unoptimized_size();
+        cached->bytecode = bc;
+        cached->lines = impl()->compile_driver_.source_lines();
+        impl()->cache_dirty_ = true;
+      }
+      impl()->reset_profile(i, cached->lines);
+      status += StringPrintf(
+          "Bytecode %u bytes (%u before optimization). ", (unsigned)bc.size(),
+          (unsigned)cached->unoptimized_size);
+      if (from_cache) {
+        status += "Cached. ";
+      }
+      vm->clear();
       // purposefully not move to get the storage reallocated to match size.
-      impl()->vm_.set_block_code(i, bc);
-      impl()->vm_.set_preamble(true);
-      impl()->vm_.save_variables(i<<16, (i+1)<<16);
-      if (!impl()->vm_.execute_block(i)) {
-        status = "Error in preamble: " + impl()->vm_.get_error();
+      vm->set_block_code(i, bc);
+      if (vm->is_native(i)) {
+        status += "Native. ";
+      }
+      vm->set_preamble(true);
+      vm->save_variables(i<<16, (i+1)<<16);
+      if (!vm->execute_block(i)) {
+        status = "Error in preamble: " + vm->get_error();
         bi->enabled = false;
       }
-      impl()->vm_.destroy_saved_variables();
+      vm->destroy_saved_variables();
+      // The preamble may have written the names of new variables into the
+      // imports table.
+      bi->loaded_hash = RunnerImpl::binding_hash(hash, bl.body(), fd);
+      // Ensures the block runs in the next step.
+      variable_factory_->variable_changed(i);
     } else {
-      impl()->vm_.clear_block_code(i);
+      vm->clear_block_code(i);
     }
     if (status != bl.body().status().read(fd)) {
       bl.body().status().write(fd, status);
     }
+    variable_factory_->send_write_batch();
+  }
+  variable_factory_->end_write_batch();
+  if (!impl()->cache_file_.empty() && impl()->cache_dirty_) {
+    impl()->save_cache();
   }
 }
 
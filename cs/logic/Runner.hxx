@@ -35,6 +35,9 @@
 #ifndef _LOGIC_RUNNER_HXX_
 #define _LOGIC_RUNNER_HXX_
 
+#include <stdint.h>
+#include <string>
+
 #include "executor/Notifiable.hxx"
 
 namespace logic {
@@ -51,7 +54,10 @@ class Runner {
   ~Runner();
   
   /// Compiles all automata, creates variables and prepares for running. Also
-  /// inquires all external states. Notifies done when completed.
+  /// inquires all external states. Notifies done when completed. Blocks that
+  /// are running and whose source code and imported variables did not change
+  /// since the last compile are left alone: they keep their variables and
+  /// state, and their status is not updated.
   void compile(Notifiable* done);
   
   /// Stops the periodic execution of the virtual machines.
@@ -59,9 +65,90 @@ class Runner {
   /// Starts the periodic execution of virtual machines.
   void start_running();
   /// Synchronously runs one execution of the virtual machines. This is called
-  /// by the automata timer but can also be used by unit tests.
+  /// by the automata timer but can also be used by unit tests. Only those
+  /// blocks are executed which had a variable change since their last
+  /// execution, or have not run for BLOCK_REFRESH_MSEC. The event reports of
+  /// the variable writes are sent after all blocks ran, and the step returns
+  /// when their local loopback is done. A block that reads an event written
+  /// by another block sees the new value in the next step.
   void single_step();
 
+  /// Requests an execution step as soon as possible, without waiting for the
+  /// next tick. Thread-safe. Does nothing if the periodic execution is not
+  /// running.
+  void wakeup();
+
+  /// Turns on parallel execution of the logic blocks. Each worker thread has
+  /// its own virtual machine, and the blocks are distributed among the
+  /// workers round-robin. In every step the workers run their blocks
+  /// concurrently, then the event messages of all blocks are sent in block
+  /// order. This means that a block sees the variable changes of other blocks
+  /// only in the next step. Useful on multi-core hosts. Must be called before
+  /// the first compile.
+  /// @param count is the number of worker threads. 0 or 1 runs all blocks on
+  /// the logic thread (default).
+  void set_worker_threads(unsigned count);
+
+  /// Sets a file where the compiled bytecode of the blocks is cached between
+  /// restarts. Blocks whose source did not change will not be compiled
+  /// again. Must be called before the first compile.
+  /// @param filename is the path to the cache file. It will be created if it
+  /// does not exist.
+  void set_cache_file(std::string filename);
+
+  /// Sets a shared object with logic blocks translated to C++ by
+  /// logic2cxx. Blocks whose bytecode matches a translated block are executed
+  /// as native code, all others by the VM. Translated code linked into the
+  /// binary is used without calling this. Only supported on Linux. Must be
+  /// called before the first compile.
+  /// @param filename is the path to the shared object.
+  void set_native_library(std::string filename);
+
+  /// How many of the hottest source lines are tracked for each block.
+  static constexpr unsigned PROFILE_HOT_LINES = 4;
+
+  /// Number of profiler samples on a source line.
+  struct HotLine {
+    /// Source line, 0 if unknown.
+    uint32_t line{0};
+    /// Number of samples on that line. 0 if the slot is unused.
+    uint32_t count{0};
+  };
+
+  /// Execution statistics of a logic block since it was last compiled.
+  struct BlockProfile {
+    /// Number of times the block was executed.
+    uint32_t executions{0};
+    /// Total number of instructions executed.
+    uint64_t insns{0};
+    /// Total execution time.
+    uint64_t total_nsec{0};
+    /// Shortest execution time.
+    uint32_t min_nsec{0};
+    /// Longest execution time.
+    uint32_t max_nsec{0};
+    /// Number of external variable reads.
+    uint32_t reads{0};
+    /// Number of external variable writes.
+    uint32_t writes{0};
+    /// Number of instruction samples taken in this block.
+    uint32_t samples{0};
+    /// The source lines with the most samples. The counts are
+    /// approximate: when a new line displaces the least used one, it
+    /// inherits that count.
+    HotLine hot_lines[PROFILE_HOT_LINES];
+  };
+
+  /// Thread-safe.
+  /// @param block_num is the index of the logic block.
+  /// @return a copy of the execution statistics of a block.
+  BlockProfile get_profile(unsigned block_num);
+
+  /// Thread-safe.
+  /// @param block_num is the index of the logic block.
+  /// @return the execution statistics of a block as human-readable text.
+  std::string profile_report(unsigned block_num);
+
   RunnerImpl* impl() {
     return impl_;
   }
@@ -50,6 +50,8 @@
 
 // The location of the current token.
 static logic::yy::location loc;
+// The scanner buffer when parsing from memory.
+static struct yy_buffer_state* source_buffer = nullptr;
 %}
 %option noyywrap nounput batch debug noinput
 id    [a-zA-Z][a-zA-Z_0-9]*
@@ -219,7 +221,9 @@ logic::Driver::scan_begin ()
 {
   yy_init_globals();
   yy_flex_debug = debug_level_ & TRACE_LEX ? true : false;
-  if (filename_.empty () || filename_ == "-")
+  if (source_buf_)
+    source_buffer = yy_scan_bytes (source_buf_, source_len_);
+  else if (filename_.empty () || filename_ == "-")
     yyin = stdin;
   else if (!(yyin = fopen (filename_.c_str (), "r")))
     {
@@ -234,6 +238,12 @@ logic::Driver::scan_begin ()
 void
 logic::Driver::scan_end ()
 {
-  fclose (yyin);
+  if (source_buffer)
+    {
+      yy_delete_buffer (source_buffer);
+      source_buffer = nullptr;
+    }
+  else
+    fclose (yyin);
 }
 
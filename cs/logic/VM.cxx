@@ -35,10 +35,17 @@
 #include <stdint.h>
 #include "logic/VM.hxx"
 #include "logic/Bytecode.hxx"
+#include "logic/NativeRuntime.hxx"
 
 #include "utils/StringPrintf.hxx"
 #include "utils/logging.h"
 
+#if defined(__GNUC__) && !defined(LOGIC_VM_NO_COMPUTED_GOTO)
+/// If defined, the pre-decoded instructions are dispatched with computed goto
+/// (direct threading), otherwise with a switch statement.
+#define LOGIC_VM_COMPUTED_GOTO
+#endif
+
 namespace logic {
 
 void BytecodeStream::append_varint(std::string* output, int value) {
@@ -125,37 +132,78 @@ bool VM::unexpected_eof(const char* where) {
   return false;
 }
 
+void VM::set_ip_sampler(unsigned period, std::function<void(ip_t)> sampler) {
+  HASSERT(period > 0);
+  insns_checkpoint_ = insns_retired();
+  ip_sampler_ = std::move(sampler);
+  insn_period_ = ip_sampler_ ? period : DEFAULT_INSN_PERIOD;
+  insn_countdown_ = insn_period_;
+}
+
+void VM::insn_period_expired(ip_t ip) {
+  insns_checkpoint_ += insn_period_;
+  insn_countdown_ = insn_period_;
+  if (ip_sampler_) ip_sampler_(ip);
+}
+
 void VM::access_error() {
   access_error_ = 1;
   error_ = StringPrintf("At IP %u: Variable access error.",
                         get_ip());
 }
 
+bool VM::init_static(int slot) {
+  auto& b = blocks_[_ip_block_num_];
+  if (slot < 0) {
+    error_ = StringPrintf("Invalid static variable slot %d for INIT_STATIC",
+                          slot);
+    return false;
+  }
+  if ((unsigned)slot >= b.statics_.size()) {
+    b.statics_.resize(slot + 1, 0);
+    b.statics_initialized_.resize(slot + 1, 0);
+  }
+  operand_stack_.push_back(b.statics_initialized_[slot] ? 0 : 1);
+  b.statics_initialized_[slot] = 1;
+  return true;
+}
+
 
-bool VM::parse_varint(int* output) {
+bool BytecodeStream::decode_varint(const uint8_t** ip, const uint8_t* eof,
+                                   int* output) {
+  const uint8_t* p = *ip;
   int ret = 0;
-  if (_ip_ >= _eof_) {
-    return unexpected_eof("parsing varint");
+  if (p >= eof) {
+    return false;
   }
-  if ((*_ip_) & 0x40) {
+  if ((*p) & 0x40) {
     ret = -1;
   }
-  ret = (ret & ~0x3F) | ((*_ip_) & 0x3F);
+  ret = (ret & ~0x3F) | ((*p) & 0x3F);
   int ofs = 6;
-  while (*_ip_ & 0x80) {
-    _ip_++;
-    if (_ip_ >= _eof_) {
-      return unexpected_eof("parsing varint");
+  while (*p & 0x80) {
+    p++;
+    if (p >= eof) {
+      *ip = p;
+      return false;
     }
     ret &= ~(0x7f << ofs);
-    ret |= ((*_ip_) & 0x7f) << ofs;
+    ret |= ((*p) & 0x7f) << ofs;
     ofs += 7;
   }
-  _ip_++;
+  p++;
+  *ip = p;
   *output = ret;
   return true;
 }
 
+bool VM::parse_varint(int* output) {
+  if (!BytecodeStream::decode_varint(&_ip_, _eof_, output)) {
+    return unexpected_eof("parsing varint");
+  }
+  return true;
+}
+
 bool VM::parse_string() {
   int len;
   string_acc_.clear();
@@ -186,8 +234,9 @@ bool VM::parse_string() {
   int name = operand_stack_.back();                                          \
   operand_stack_.pop_back();
 
-bool VM::execute() {
+bool VM::execute_switch() {
   while(!at_eof()) {
+    if (--insn_countdown_ == 0) insn_period_expired(get_ip());
     volatile uint8_t insn = fetch_insn();
     switch(insn) {
       case TERMINATE:
@@ -257,9 +306,8 @@ bool VM::execute() {
           error_ = "Invalid indirect variable reference.";
           return false;
         }
-        const VMVariableReference& ref = variable_stack_[varidx];
-        int val = ref.var->read(variable_factory_, ref.arg);
-        if (access_error_) return false;
+        int val;
+        if (!indirect_load(variable_stack_[varidx], &val)) return false;
         operand_stack_.push_back(val);
         break;
       }
@@ -270,9 +318,7 @@ bool VM::execute() {
           error_ = "Invalid indirect variable reference.";
           return false;
         }
-        const VMVariableReference& ref = variable_stack_[varidx];
-        ref.var->write(variable_factory_, ref.arg, value);
-        if (access_error_) return false;
+        if (!indirect_store(variable_stack_[varidx], value)) return false;
         break;
       }
       case PUSH_TOP: {
@@ -343,26 +389,44 @@ bool VM::execute() {
       case CREATE_INDIRECT_VAR: {
         GET_VARINT(fpofs);
         VMVariableReference ref;
-        ref.var = &operand_stack_variables_;
+        ref.storage = VMVariableReference::OPERAND_STACK;
         ref.arg = fp_ + fpofs;
         variable_stack_.emplace_back(std::move(ref));
         operand_stack_.push_back(variable_stack_.size() - 1);
         break;
       }
-      case CREATE_STATIC_VAR: {
-        GET_VARINT(guid);
-        bool created = false;
-        auto& global_ref = external_variables_[guid];
-        if (!global_ref.get()) {
-          created = true;
-          global_ref.reset(new StaticVariable);
+      case INIT_STATIC: {
+        GET_VARINT(slot);
+        if (!init_static(slot)) return false;
+        break;
+      }
+      case LOAD_STATIC: {
+        GET_VARINT(slot);
+        const auto& statics = blocks_[_ip_block_num_].statics_;
+        if ((unsigned)slot >= statics.size()) {
+          error_ = "Invalid static variable slot for LOAD_STATIC";
+          return false;
+        }
+        operand_stack_.push_back(statics[slot]);
+        break;
+      }
+      case STORE_STATIC: {
+        GET_FROM_STACK(val, "STORE_STATIC");
+        GET_VARINT(slot);
+        if (!store_static(_ip_block_num_, slot, val)) {
+          error_ = "Invalid static variable slot for STORE_STATIC";
+          return false;
         }
+        break;
+      }
+      case CREATE_INDIRECT_STATIC: {
+        GET_VARINT(slot);
         VMVariableReference ref;
-        ref.var = global_ref.get();
-        ref.arg = 0;
+        ref.storage = VMVariableReference::STATIC_SLOT;
+        ref.arg = slot;
+        ref.block = _ip_block_num_;
         variable_stack_.emplace_back(std::move(ref));
         operand_stack_.push_back(variable_stack_.size() - 1);
-        operand_stack_.push_back(created ? 1 : 0);
         break;
       }
       case NUMERIC_PLUS: {
@@ -533,6 +597,11 @@ bool VM::execute() {
         print_cb_(string_acc_);
         break;
       }
+      case SOURCE_LINE: {
+        GET_VARINT(line);
+        (void)line;
+        break;
+      }
       case NOP:
         break;
       default:
@@ -543,4 +612,689 @@ bool VM::execute() {
   return true;
 };
 
+void VM::predecode_block(BlockInfo* block) {
+  block->clear_decoded();
+  threaded_ = 0;
+  if (!use_predecode_) {
+    return;
+  }
+  const std::string& code = block->code_;
+  const uint8_t* start = (const uint8_t*)code.data();
+  const uint8_t* eof = start + code.size();
+  const uint8_t* ip = start;
+  std::vector<DecodedInsn> insns;
+  std::vector<std::string> strings;
+  DecodedInsn d;
+  d.handler = nullptr;
+  while (ip < eof) {
+    d.arg = 0;
+    d.arg2 = 0;
+    d.ofs = ip - start;
+    d.opcode = (OpCode)*ip++;
+    switch (d.opcode) {
+      case TERMINATE:
+      case PUSH_CONSTANT_0:
+      case PUSH_CONSTANT_1:
+      case PUSH_TOP:
+      case POP_OP:
+      case INDIRECT_LOAD:
+      case INDIRECT_STORE:
+      case IMPORT_VAR:
+      case NUMERIC_PLUS:
+      case NUMERIC_MINUS:
+      case NUMERIC_MUL:
+      case NUMERIC_DIV:
+      case NUMERIC_MOD:
+      case BOOL_EQ:
+      case BOOL_NEQ:
+      case NUMERIC_LEQ:
+      case NUMERIC_GEQ:
+      case NUMERIC_LT:
+      case NUMERIC_GT:
+      case NUMERIC_EQ:
+      case NUMERIC_NEQ:
+      case BOOL_NOT:
+      case BOOL_PROJECT:
+      case IF_PREAMBLE:
+      case RET:
+      case PRINT_NUM:
+      case PRINT_STR:
+      case NOP:
+        break;
+      case PUSH_CONSTANT:
+      case ENTER:
+      case LEAVE:
+      case CHECK_STACK_LENGTH:
+      case STORE_FP_REL:
+      case LOAD_FP_REL:
+      case INIT_STATIC:
+      case LOAD_STATIC:
+      case STORE_STATIC:
+      case CREATE_INDIRECT_STATIC:
+      case CREATE_INDIRECT_VAR:
+      case JUMP:
+      case CALL:
+      case TEST_JUMP_IF_FALSE:
+      case TEST_JUMP_IF_TRUE:
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg)) return;
+        break;
+      case CREATE_VAR:
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg)) return;
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg2)) return;
+        break;
+      case SOURCE_LINE:
+        // Only needed for the source line table; executes as a NOP.
+        if (!BytecodeStream::decode_varint(&ip, eof, &d.arg)) return;
+        d.opcode = NOP;
+        break;
+      case LOAD_STRING: {
+        int len;
+        if (!BytecodeStream::decode_varint(&ip, eof, &len)) return;
+        if (len < 0 || ip + len > eof) return;
+        d.arg = strings.size();
+        strings.emplace_back((const char*)ip, len);
+        ip += len;
+        break;
+      }
+      default:
+        // Unknown to the decoder; the interpreter will handle this block.
+        return;
+    }
+    d.next_ofs = ip - start;
+    insns.push_back(d);
+  }
+  // Sentinel: running off the end of the code terminates the block.
+  d.arg = 0;
+  d.arg2 = 0;
+  d.ofs = d.next_ofs = code.size();
+  d.opcode = TERMINATE;
+  insns.push_back(d);
+
+  // Resolves jump targets to instruction indexes.
+  for (auto& di : insns) {
+    int target = di.next_ofs + di.arg;
+    switch (di.opcode) {
+      case JUMP:
+        // The interpreter ignores jumps outside of the block, we do not
+        // replicate that.
+        if (target < 0 || target > (int)code.size()) return;
+        break;
+      case TEST_JUMP_IF_FALSE:
+      case TEST_JUMP_IF_TRUE:
+        if (target < 0) return;
+        if (target > (int)code.size()) target = code.size();
+        break;
+      default:
+        continue;
+    }
+    int idx = find_decoded_insn(insns, target);
+    if (idx < 0) return;
+    di.arg = idx;
+  }
+  block->decoded_.swap(insns);
+  block->strings_.swap(strings);
+}
+
+int VM::find_decoded_insn(const std::vector<DecodedInsn>& insns,
+                          unsigned ofs) {
+  unsigned lo = 0;
+  unsigned hi = insns.size();
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (insns[mid].ofs < ofs) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < insns.size() && insns[lo].ofs == ofs) {
+    return lo;
+  }
+  return -1;
+}
+
+bool VM::execute() {
+  if (_ip_block_num_ < blocks_.size() && blocks_[_ip_block_num_].native_) {
+    NativeRuntime rt(this);
+    return blocks_[_ip_block_num_].native_(&rt, _ip_ - _block_start_);
+  }
+  return execute_interpreted();
+}
+
+bool VM::execute_interpreted() {
+  if (_ip_block_num_ < blocks_.size()) {
+    const auto& b = blocks_[_ip_block_num_];
+    if (!b.decoded_.empty()) {
+      int idx = find_decoded_insn(b.decoded_, _ip_ - _block_start_);
+      if (idx >= 0) {
+        return execute_decoded(idx);
+      }
+    }
+  }
+  return execute_switch();
+}
+
+/// Counts the instruction at pc as executed.
+#define COUNT_INSN()                                                        \
+  if (--insn_countdown_ == 0) {                                             \
+    insn_period_expired((_ip_block_num_ << BLOCK_CODE_IP_SHIFT) | pc->ofs); \
+  }
+
+#ifdef LOGIC_VM_COMPUTED_GOTO
+#define DISPATCH()     \
+  do {                 \
+    COUNT_INSN();      \
+    goto *pc->handler; \
+  } while (0)
+#define OP_LABEL(op) case op: L_##op
+#else
+#define DISPATCH() goto dispatch
+#define OP_LABEL(op) case op
+#endif
+
+#define NEXT() \
+  ++pc;        \
+  DISPATCH()
+
+/// Updates the byte IP to the end of the current decoded instruction.
+#define SYNC_IP() _ip_ = _block_start_ + pc->next_ofs
+
+#define DECODED_POP(name, INSN)                                               \
+  if (operand_stack_.empty()) {                                               \
+    SYNC_IP();                                                                \
+    error_ = StringPrintf("Stack underflow at ip %u insn %02x %s", get_ip(), \
+                          (unsigned)pc->opcode, INSN);                        \
+    return false;                                                             \
+  }                                                                           \
+  int name = operand_stack_.back();                                           \
+  operand_stack_.pop_back();
+
+bool VM::execute_decoded(unsigned idx) {
+#ifdef LOGIC_VM_COMPUTED_GOTO
+  if (!threaded_) {
+    for (auto& b : blocks_) {
+      for (auto& d : b.decoded_) {
+        switch (d.opcode) {
+#define THREAD_OP(op)     \
+  case op:                \
+    d.handler = &&L_##op; \
+    break;
+          THREAD_OP(TERMINATE)
+          THREAD_OP(PUSH_CONSTANT)
+          THREAD_OP(PUSH_CONSTANT_0)
+          THREAD_OP(PUSH_CONSTANT_1)
+          THREAD_OP(PUSH_TOP)
+          THREAD_OP(POP_OP)
+          THREAD_OP(ENTER)
+          THREAD_OP(LEAVE)
+          THREAD_OP(CHECK_STACK_LENGTH)
+          THREAD_OP(STORE_FP_REL)
+          THREAD_OP(LOAD_FP_REL)
+          THREAD_OP(INDIRECT_LOAD)
+          THREAD_OP(INDIRECT_STORE)
+          THREAD_OP(LOAD_STRING)
+          THREAD_OP(CREATE_VAR)
+          THREAD_OP(INIT_STATIC)
+          THREAD_OP(LOAD_STATIC)
+          THREAD_OP(STORE_STATIC)
+          THREAD_OP(CREATE_INDIRECT_STATIC)
+          THREAD_OP(IMPORT_VAR)
+          THREAD_OP(CREATE_INDIRECT_VAR)
+          THREAD_OP(NUMERIC_PLUS)
+          THREAD_OP(NUMERIC_MINUS)
+          THREAD_OP(NUMERIC_MUL)
+          THREAD_OP(NUMERIC_DIV)
+          THREAD_OP(NUMERIC_MOD)
+          THREAD_OP(BOOL_EQ)
+          THREAD_OP(BOOL_NEQ)
+          THREAD_OP(NUMERIC_LEQ)
+          THREAD_OP(NUMERIC_GEQ)
+          THREAD_OP(NUMERIC_LT)
+          THREAD_OP(NUMERIC_GT)
+          THREAD_OP(NUMERIC_EQ)
+          THREAD_OP(NUMERIC_NEQ)
+          THREAD_OP(BOOL_NOT)
+          THREAD_OP(BOOL_PROJECT)
+          THREAD_OP(IF_PREAMBLE)
+          THREAD_OP(JUMP)
+          THREAD_OP(CALL)
+          THREAD_OP(RET)
+          THREAD_OP(TEST_JUMP_IF_FALSE)
+          THREAD_OP(TEST_JUMP_IF_TRUE)
+          THREAD_OP(PRINT_NUM)
+          THREAD_OP(PRINT_STR)
+          THREAD_OP(NOP)
+#undef THREAD_OP
+          default:
+            DIE("Unexpected opcode in decoded logic block.");
+        }
+      }
+    }
+    threaded_ = 1;
+  }
+#endif
+  BlockInfo* blk = &blocks_[_ip_block_num_];
+  const DecodedInsn* base = blk->decoded_.data();
+  const DecodedInsn* pc = base + idx;
+
+#ifdef LOGIC_VM_COMPUTED_GOTO
+  DISPATCH();
+#else
+dispatch:
+  COUNT_INSN();
+#endif
+  switch (pc->opcode) {
+    OP_LABEL(TERMINATE): {
+      SYNC_IP();
+      return true;
+    }
+    OP_LABEL(PUSH_CONSTANT): {
+      operand_stack_.push_back(pc->arg);
+      NEXT();
+    }
+    OP_LABEL(PUSH_CONSTANT_0): {
+      operand_stack_.push_back(0);
+      NEXT();
+    }
+    OP_LABEL(PUSH_CONSTANT_1): {
+      operand_stack_.push_back(1);
+      NEXT();
+    }
+    OP_LABEL(PUSH_TOP): {
+      if (operand_stack_.size() < 1) {
+        error_ = StringPrintf("Stack underflow at PUSH_TOP");
+        SYNC_IP();
+        return false;
+      }
+      operand_stack_.push_back(operand_stack_.back());
+      NEXT();
+    }
+    OP_LABEL(POP_OP): {
+      if (operand_stack_.size() < 1) {
+        error_ = StringPrintf("Stack underflow at POP_OP");
+        SYNC_IP();
+        return false;
+      }
+      operand_stack_.pop_back();
+      NEXT();
+    }
+    OP_LABEL(ENTER): {
+      operand_stack_.resize(operand_stack_.size() + pc->arg);
+      NEXT();
+    }
+    OP_LABEL(LEAVE): {
+      int r = pc->arg;
+      if (r < 0) {
+        SYNC_IP();
+        error_ = StringPrintf("At IP %u: LEAVE with negative argument %d.",
+                              get_ip(), r);
+        return false;
+      }
+      if (r > (int)operand_stack_.size()) {
+        SYNC_IP();
+        error_ = StringPrintf(
+            "At IP %u: Stack underflow with LEAVE; arg=%d stack size=%u",
+            get_ip(), r, (int)operand_stack_.size());
+        return false;
+      }
+      operand_stack_.resize(operand_stack_.size() - r);
+      NEXT();
+    }
+    OP_LABEL(CHECK_STACK_LENGTH): {
+      if (operand_stack_.size() != (unsigned)(fp_ + pc->arg)) {
+        SYNC_IP();
+        error_ = StringPrintf(
+            "At IP %u: Operand stack length error, expected %d, actual %u.",
+            get_ip(), pc->arg, (unsigned)operand_stack_.size());
+        return false;
+      }
+      NEXT();
+    }
+    OP_LABEL(STORE_FP_REL): {
+      DECODED_POP(val, "STORE_FP_REL");
+      unsigned ofs = fp_ + pc->arg;
+      if (ofs >= operand_stack_.size()) {
+        SYNC_IP();
+        error_ = "Invalid relative offset for STORE_FP_REL";
+        return false;
+      }
+      operand_stack_[ofs] = val;
+      NEXT();
+    }
+    OP_LABEL(LOAD_FP_REL): {
+      unsigned ofs = fp_ + pc->arg;
+      if (ofs >= operand_stack_.size()) {
+        SYNC_IP();
+        error_ = "Invalid relative offset for LOAD_FP_REL";
+        return false;
+      }
+      int val = operand_stack_[ofs];
+      operand_stack_.push_back(val);
+      NEXT();
+    }
+    OP_LABEL(INDIRECT_LOAD): {
+      DECODED_POP(varidx, "INDIRECT_LOAD");
+      if (varidx < 0 || (unsigned)varidx >= variable_stack_.size()) {
+        SYNC_IP();
+        error_ = "Invalid indirect variable reference.";
+        return false;
+      }
+      int val;
+      if (!indirect_load(variable_stack_[varidx], &val)) {
+        // Renders the error message again with the correct IP.
+        SYNC_IP();
+        access_error();
+        return false;
+      }
+      operand_stack_.push_back(val);
+      NEXT();
+    }
+    OP_LABEL(INDIRECT_STORE): {
+      DECODED_POP(varidx, "INDIRECT_STORE");
+      DECODED_POP(value, "INDIRECT_STORE");
+      if (varidx < 0 || (unsigned)varidx >= variable_stack_.size()) {
+        SYNC_IP();
+        error_ = "Invalid indirect variable reference.";
+        return false;
+      }
+      if (!indirect_store(variable_stack_[varidx], value)) {
+        SYNC_IP();
+        access_error();
+        return false;
+      }
+      NEXT();
+    }
+    OP_LABEL(LOAD_STRING): {
+      string_acc_ = blk->strings_[pc->arg];
+      NEXT();
+    }
+    OP_LABEL(CREATE_VAR): {
+      int guid = pc->arg;
+      int num_states = pc->arg2;
+      variable_request_.name = std::move(string_acc_);
+      variable_request_.block_num = block_num_;
+      if (num_states >= 0) {
+        variable_request_.type = VariableCreationRequest::TYPE_INT;
+        variable_request_.num_states = num_states;
+      }
+      LOG(VERBOSE, "create variable name %s st %d type %d",
+          variable_request_.name.c_str(), num_states, variable_request_.type);
+      auto var = variable_factory_->create_variable(&variable_request_);
+      if (!var) {
+        SYNC_IP();
+        error_ = StringPrintf("Error creating variable '%s'.",
+                              variable_request_.name.c_str());
+        return false;
+      }
+      variable_request_.clear();
+      external_variables_[guid] = std::move(var);
+      NEXT();
+    }
+    OP_LABEL(IMPORT_VAR): {
+      DECODED_POP(arg, "IMPORT_VAR");
+      DECODED_POP(guid, "IMPORT_VAR");
+      auto it = external_variables_.find(guid);
+      if (it == external_variables_.end()) {
+        SYNC_IP();
+        error_ = StringPrintf("Unknown variable GUID %d at IMPORT_VAR", guid);
+        return false;
+      }
+      VMVariableReference ref;
+      ref.var = it->second.get();
+      ref.arg = arg;
+      variable_stack_.emplace_back(std::move(ref));
+      operand_stack_.push_back(variable_stack_.size() - 1);
+      NEXT();
+    }
+    OP_LABEL(CREATE_INDIRECT_VAR): {
+      VMVariableReference ref;
+      ref.storage = VMVariableReference::OPERAND_STACK;
+      ref.arg = fp_ + pc->arg;
+      variable_stack_.emplace_back(std::move(ref));
+      operand_stack_.push_back(variable_stack_.size() - 1);
+      NEXT();
+    }
+    OP_LABEL(INIT_STATIC): {
+      if (!init_static(pc->arg)) {
+        SYNC_IP();
+        return false;
+      }
+      NEXT();
+    }
+    OP_LABEL(LOAD_STATIC): {
+      const auto& statics = blk->statics_;
+      if ((unsigned)pc->arg >= statics.size()) {
+        SYNC_IP();
+        error_ = "Invalid static variable slot for LOAD_STATIC";
+        return false;
+      }
+      operand_stack_.push_back(statics[pc->arg]);
+      NEXT();
+    }
+    OP_LABEL(STORE_STATIC): {
+      DECODED_POP(val, "STORE_STATIC");
+      if (!store_static(_ip_block_num_, pc->arg, val)) {
+        SYNC_IP();
+        error_ = "Invalid static variable slot for STORE_STATIC";
+        return false;
+      }
+      NEXT();
+    }
+    OP_LABEL(CREATE_INDIRECT_STATIC): {
+      VMVariableReference ref;
+      ref.storage = VMVariableReference::STATIC_SLOT;
+      ref.arg = pc->arg;
+      ref.block = _ip_block_num_;
+      variable_stack_.emplace_back(std::move(ref));
+      operand_stack_.push_back(variable_stack_.size() - 1);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_PLUS): {
+      DECODED_POP(rhs, "NUMERIC_PLUS");
+      DECODED_POP(lhs, "NUMERIC_PLUS");
+      operand_stack_.push_back(lhs + rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_MINUS): {
+      DECODED_POP(rhs, "");
+      DECODED_POP(lhs, "");
+      operand_stack_.push_back(lhs - rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_MUL): {
+      DECODED_POP(rhs, "");
+      DECODED_POP(lhs, "");
+      operand_stack_.push_back(lhs * rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_DIV): {
+      DECODED_POP(rhs, "");
+      DECODED_POP(lhs, "");
+      if (rhs == 0) {
+        SYNC_IP();
+        error_ = StringPrintf("Div by zero");
+        return false;
+      }
+      operand_stack_.push_back(lhs / rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_MOD): {
+      DECODED_POP(rhs, "");
+      DECODED_POP(lhs, "");
+      if (rhs == 0) {
+        SYNC_IP();
+        error_ = StringPrintf("Div by zero");
+        return false;
+      }
+      operand_stack_.push_back(lhs % rhs);
+      NEXT();
+    }
+    OP_LABEL(BOOL_EQ): {
+      DECODED_POP(rhs, "BOOLEQ");
+      DECODED_POP(lhs, "BOOLEQ");
+      operand_stack_.push_back((!!lhs) == (!!rhs));
+      NEXT();
+    }
+    OP_LABEL(BOOL_NEQ): {
+      DECODED_POP(rhs, "BOOLNEQ");
+      DECODED_POP(lhs, "BOOLNEQ");
+      operand_stack_.push_back((!!lhs) != (!!rhs));
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_LEQ): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs <= rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_GEQ): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs >= rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_LT): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs < rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_GT): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs > rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_EQ): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs == rhs);
+      NEXT();
+    }
+    OP_LABEL(NUMERIC_NEQ): {
+      DECODED_POP(rhs, "INTCOMP");
+      DECODED_POP(lhs, "INTCOMP");
+      operand_stack_.push_back(lhs != rhs);
+      NEXT();
+    }
+    OP_LABEL(BOOL_NOT): {
+      DECODED_POP(rhs, "");
+      operand_stack_.push_back(rhs == 0 ? 1 : 0);
+      NEXT();
+    }
+    OP_LABEL(BOOL_PROJECT): {
+      DECODED_POP(rhs, "");
+      operand_stack_.push_back(rhs == 0 ? 0 : 1);
+      NEXT();
+    }
+    OP_LABEL(IF_PREAMBLE): {
+      operand_stack_.push_back(is_preamble_ ? 1 : 0);
+      NEXT();
+    }
+    OP_LABEL(JUMP): {
+      pc = base + pc->arg;
+      DISPATCH();
+    }
+    OP_LABEL(CALL): {
+      if (call_stack_.size() < 1) {
+        SYNC_IP();
+        error_ = StringPrintf("Call stack underflow at CALL");
+        return false;
+      }
+      if (fp_ != call_stack_.back().fp) {
+        SYNC_IP();
+        error_ = StringPrintf("Unexpected fp at CALL. Expected %d actual %d",
+                              call_stack_.back().fp, fp_);
+        return false;
+      }
+      DECODED_POP(dst, "");
+      SYNC_IP();
+      call_stack_.emplace_back();
+      call_stack_.back().return_address = get_ip();
+      call_stack_.back().fp = operand_stack_.size() - pc->arg;
+      fp_ = call_stack_.back().fp;
+      call_stack_.back().vp = variable_stack_.size();
+      if (!jump(dst)) {
+        // Same as the interpreter: invalid call target is ignored.
+        NEXT();
+      }
+      goto transfer;
+    }
+    OP_LABEL(RET): {
+      if (call_stack_.size() <= 1) {
+        SYNC_IP();
+        error_ = StringPrintf("Call stack underflow at RET");
+        return false;
+      }
+      const auto& s = call_stack_.back();
+      variable_stack_.resize(s.vp);
+      operand_stack_.resize(s.fp);
+      ip_t return_address = s.return_address;
+      call_stack_.pop_back();
+      fp_ = call_stack_.back().fp;
+      SYNC_IP();
+      if (!jump(return_address)) {
+        NEXT();
+      }
+      goto transfer;
+    }
+    OP_LABEL(TEST_JUMP_IF_FALSE): {
+      DECODED_POP(arg, "TEST_JUMP_IF_FALSE");
+      if (arg == 0) {
+        pc = base + pc->arg;
+      } else {
+        ++pc;
+      }
+      DISPATCH();
+    }
+    OP_LABEL(TEST_JUMP_IF_TRUE): {
+      DECODED_POP(arg, "TEST_JUMP_IF_TRUE");
+      if (arg != 0) {
+        pc = base + pc->arg;
+      } else {
+        ++pc;
+      }
+      DISPATCH();
+    }
+    OP_LABEL(PRINT_NUM): {
+      DECODED_POP(arg, "PRINT_NUM");
+      print_cb_(StringPrintf("%d", arg));
+      NEXT();
+    }
+    OP_LABEL(PRINT_STR): {
+      print_cb_(string_acc_);
+      NEXT();
+    }
+    OP_LABEL(NOP): {
+      NEXT();
+    }
+    default:
+      DIE("Unexpected opcode in decoded logic block.");
+  }
+
+transfer:
+  // Control was transferred to a byte IP (call or return). Continues in the
+  // decoded instruction stream if possible, otherwise in the interpreter.
+  blk = &blocks_[_ip_block_num_];
+  if (blk->decoded_.empty()) {
+    return execute_switch();
+  }
+  {
+    int target = find_decoded_insn(blk->decoded_, _ip_ - _block_start_);
+    if (target < 0) {
+      return execute_switch();
+    }
+    base = blk->decoded_.data();
+    pc = base + target;
+  }
+  DISPATCH();
+}
+
+#undef COUNT_INSN
+#undef DISPATCH
+#undef OP_LABEL
+#undef NEXT
+#undef SYNC_IP
+#undef DECODED_POP
+
 } // namespace logic
@@ -44,9 +44,11 @@
 #include <vector>
 #include <map>
 
+#include "logic/NativeBlock.hxx"
 #include "logic/Variable.hxx"
 
 #include "utils/macros.h"
+#include "logic/Bytecode.hxx"
 
 namespace logic {
 
@@ -58,15 +60,22 @@ class VM {
   /// the VM. Ownership is not transferred.
   VM(VariableFactory* factory)
       : variable_factory_(factory),
+        insn_period_(DEFAULT_INSN_PERIOD),
+        insn_countdown_(DEFAULT_INSN_PERIOD),
         block_num_(0),
         is_preamble_(0),
-        access_error_(0) {
+        access_error_(0),
+        use_predecode_(1),
+        use_native_(1),
+        threaded_(0) {
     factory->set_access_error_callback(std::bind(&VM::access_error, this));
   }
 
   /// Executes instructions from the current IP. Return true if execution
   /// succeeded (hit the last byte or a TERMINATE command), false if an
-  /// exception was generated.
+  /// exception was generated. Uses the translated C++ code of the block if
+  /// one is registered, else the pre-decoded form of the block if available,
+  /// otherwise interprets the bytecode directly.
   bool execute();
   
   bool execute(const std::string& ops) {
@@ -89,21 +98,54 @@ class VM {
   }
 
   /// Call this after compile and pass in the compiled bytecode.
-  /// The given code can then be executed by execute_block().
+  /// The given code can then be executed by execute_block(). The static
+  /// variables of the block are kept if the code is unchanged, otherwise
+  /// they will be initialized again.
   void set_block_code(uint8_t block_num, std::string code) {
     HASSERT(code.size() < (1u << BLOCK_CODE_IP_SHIFT));
     if (blocks_.size() <= block_num) {
       blocks_.resize(block_num + 1);
     }
+    if (blocks_[block_num].code_ != code) {
+      blocks_[block_num].clear_statics();
+    }
     blocks_[block_num].code_.swap(code);
+    predecode_block(&blocks_[block_num]);
+    blocks_[block_num].native_ =
+        use_native_ ? find_native_block(blocks_[block_num].code_) : nullptr;
   }
 
   void clear_block_code(uint8_t block_num) {
     if (blocks_.size() > block_num) {
       std::string s;
       blocks_[block_num].code_.swap(s);
+      blocks_[block_num].clear_decoded();
+      blocks_[block_num].clear_statics();
+      blocks_[block_num].native_ = nullptr;
     }
   }
+
+  /// Sets whether blocks should be lowered into pre-decoded instructions when
+  /// their code is set. When disabled, all execution goes through the
+  /// bytecode interpreter. Affects only subsequent set_block_code() calls.
+  /// @param enabled true to use the pre-decoded engine (default).
+  void set_predecode(bool enabled) {
+    use_predecode_ = enabled ? 1 : 0;
+  }
+
+  /// Sets whether blocks should be executed by their translated C++ code
+  /// (see NativeBlock.hxx) when one is registered for the bytecode. Affects
+  /// only subsequent set_block_code() calls.
+  /// @param enabled true to use the translated code (default).
+  void set_native(bool enabled) {
+    use_native_ = enabled ? 1 : 0;
+  }
+
+  /// @param block_num is the number of a block.
+  /// @return true if the block is executed by translated C++ code.
+  bool is_native(uint8_t block_num) {
+    return block_num < blocks_.size() && blocks_[block_num].native_;
+  }
   
   /// @return exception description if the execution failed.
   const std::string& get_error() {
@@ -116,6 +158,15 @@ class VM {
     print_cb_ = std::move(cb);
   }
 
+  /// Makes the access errors of the variables of a block be reported to this
+  /// VM instead of the last VM created on the variable factory. Needed when
+  /// several VMs execute blocks in parallel.
+  /// @param block_num is a logic block executed by this VM.
+  void route_access_errors(unsigned block_num) {
+    variable_factory_->set_block_access_error_callback(
+        block_num, std::bind(&VM::access_error, this));
+  }
+
   /// Defines the value in the "block_num" parameter of variable creation
   /// requests.
   void set_block_num(unsigned block_num) {
@@ -143,10 +194,50 @@ class VM {
 
   typedef unsigned ip_t;
 
+  /// Sets up sampling of the executed instructions, for profiling.
+  /// @param period is the number of instructions executed between two
+  /// samples. Must be positive.
+  /// @param sampler will be called with the IP of every period-th executed
+  /// instruction. An empty function turns sampling off.
+  void set_ip_sampler(unsigned period, std::function<void(ip_t)> sampler);
+
+  /// @param ip is an instruction pointer.
+  /// @return the number of the logic block the IP points into.
+  static unsigned ip_block_num(ip_t ip) {
+    return ip >> BLOCK_CODE_IP_SHIFT;
+  }
+
+  /// @param ip is an instruction pointer.
+  /// @return the offset of the IP in the bytecode of its block.
+  static unsigned ip_offset(ip_t ip) {
+    return ip & ((1u << BLOCK_CODE_IP_SHIFT) - 1);
+  }
+
+  /// @return the number of instructions executed by this VM so far.
+  uint64_t insns_retired() {
+    return insns_checkpoint_ + (insn_period_ - insn_countdown_);
+  }
+
+  /// @return the number of reads from external variables executed by this
+  /// VM so far.
+  unsigned external_reads() {
+    return external_reads_;
+  }
+
+  /// @return the number of writes to external variables executed by this
+  /// VM so far.
+  unsigned external_writes() {
+    return external_writes_;
+  }
+
  private:
   friend class BytecodeTest;
   friend class VMTest;
-  friend class VMAbsoluteVariable;
+  friend class OptimizerTest;
+  friend class NativeRuntime;
+
+  /// Instruction countdown period when there is no sampler.
+  static constexpr uint32_t DEFAULT_INSN_PERIOD = 1u << 30;
 
   /// Number of bits reserved for IPs within a single block.
   static constexpr unsigned BLOCK_CODE_IP_SHIFT = 16;
@@ -165,6 +256,22 @@ class VM {
   /// @return true if the current IP points outside of the valid range.
   inline bool at_eof();
 
+  /// Executes instructions from the current IP with the pre-decoded form of
+  /// the block if available, otherwise with the bytecode interpreter.
+  /// @return same as execute().
+  bool execute_interpreted();
+
+  /// Bytecode interpreter. Executes instructions from the current IP until
+  /// the end of the block or a TERMINATE. Also used as a fallback for blocks
+  /// that could not be pre-decoded.
+  bool execute_switch();
+
+  /// Executes the pre-decoded instructions of the current block.
+  /// @param idx is the index of the first instruction to run in the decoded
+  /// instruction array of the block at _ip_block_num_.
+  /// @return same as execute().
+  bool execute_decoded(unsigned idx);
+
   /// Retrieves the next instruction from the instruction stream. Increments
   /// the instruction pointer.
   /// @return the uint8 of the next instruction value.
@@ -188,6 +295,11 @@ class VM {
   /// Adds a Variable Access Error.
   void access_error();
 
+  /// Called when insn_countdown_ reaches zero. Takes a sample and restarts
+  /// the countdown.
+  /// @param ip is the IP of the instruction about to be executed.
+  void insn_period_expired(ip_t ip);
+
   struct ExecutionEnvironment {
     /// Frame pointer. Indexes into the operand_stack_ to define the base for
     /// all relative offset variables. When exiting a function, the operand
@@ -206,59 +318,119 @@ class VM {
 
   /// Instances of this struct will be pushed to the variable stack.
   struct VMVariableReference {
+    /// Where the value of a variable is stored.
+    enum Storage : uint8_t {
+      /// In an external Variable object; accessed via virtual calls.
+      EXTERNAL,
+      /// On the operand stack (local variable). arg is the absolute index.
+      OPERAND_STACK,
+      /// In the static variable array of a block. arg is the slot.
+      STATIC_SLOT,
+    };
     /// Holds ownership of a variable if it was created locally.
     std::unique_ptr<Variable> owned_var;
-    /// Non-owned variable. owned_var is always copied here.
-    Variable* var;
-    /// Argument to supply to the variable calls.
+    /// Non-owned variable. owned_var is always copied here. Only used when
+    /// storage is EXTERNAL.
+    Variable* var{nullptr};
+    /// Argument to supply to the variable calls, or index of the storage
+    /// slot for internal variables.
     unsigned arg;
+    /// Which storage the variable is in.
+    Storage storage{EXTERNAL};
+    /// For STATIC_SLOT, the block that owns the static variable array.
+    uint8_t block{0};
   };
 
-  /// Implementation of the Variable interface that points to a temporary on
-  /// the operand stack. This is used when a local variable (from the operand
-  /// stack) is passed as a mutable value to a function.
-  class VMAbsoluteVariable : public Variable {
-   public:
-    VMAbsoluteVariable(VM* parent) : parent_(parent) {}
-
-    /// @return the largest valid state value to write or return from this
-    /// variable.
-    int max_state() override {
-      return INT_MAX;
-    }
-
-    /// @param parent is the variable factory that created this variable.
-    /// @param arg is the index for vector variables, zero if not used.
-    /// @return the current value of this variable.
-    int read(const VariableFactory* parent, unsigned arg) override {
-      if (parent_->operand_stack_.size() <= arg) {
-        parent_->access_error();
-        return -1;
-      }
-      return parent_->operand_stack_[arg];
-    }
-
-    /// Write a value to the variable.
-    /// @param parent is the variable factory that created this variable.
-    /// @param arg is the index for vector variables, zero if not used.
-    /// @param value is the new (desired) state of the variable.
-    void write(const VariableFactory* parent, unsigned arg,
-               int value) override {
-      if (parent_->operand_stack_.size() <= arg) {
-        parent_->access_error();
-        return;
-      }
-      parent_->operand_stack_[arg] = value;
-    }
+  /// Reads the value of a variable on the variable stack.
+  /// @param ref is the variable reference.
+  /// @param value will be filled with the value of the variable.
+  /// @return false upon an access error.
+  inline bool indirect_load(const VMVariableReference& ref, int* value);
+
+  /// Writes the value of a variable on the variable stack.
+  /// @param ref is the variable reference.
+  /// @param value is the new value of the variable.
+  /// @return false upon an access error.
+  inline bool indirect_store(const VMVariableReference& ref, int value);
+
+  /// Writes a static variable of a block. Schedules the block for execution
+  /// if the value changed.
+  /// @param block_num is the block owning the static variable.
+  /// @param slot is the index of the variable in the static variable array.
+  /// @param value is the new value of the variable.
+  /// @return false if the slot is invalid.
+  inline bool store_static(unsigned block_num, unsigned slot, int value);
+
+  /// Implements INIT_STATIC for the current block.
+  /// @param slot is the index of the static variable.
+  /// @return false if the slot is invalid.
+  bool init_static(int slot);
+
+  /// One instruction of a block after lowering the bytecode. All operands
+  /// are expanded and jump targets are resolved to instruction indexes.
+  struct DecodedInsn {
+    /// Address of the handler in execute_decoded (direct threading). Filled
+    /// in lazily upon the first execution.
+    const void* handler;
+    /// First operand. For JUMP and TEST_JUMP_* it is the index of the target
+    /// instruction; for LOAD_STRING the index into the string table.
+    int arg;
+    /// Second operand (only for CREATE_VAR).
+    int arg2;
+    /// Byte offset of this instruction in the bytecode.
+    uint16_t ofs;
+    /// Byte offset of the next instruction in the bytecode, i.e. the IP after
+    /// the operands of this instruction were fetched.
+    uint16_t next_ofs;
+    /// Instruction to execute.
+    OpCode opcode;
+  };
 
-    VM* parent_;
-  } operand_stack_variables_{this};
-  
   struct BlockInfo {
     /// The compiled bytecode for the block.
     std::string code_;
+    /// Pre-decoded instructions of code_. Empty if the block could not be
+    /// lowered; then the bytecode interpreter executes it. Terminated by an
+    /// extra TERMINATE instruction pointing at the end of the bytecode.
+    std::vector<DecodedInsn> decoded_;
+    /// String arguments of the LOAD_STRING instructions in decoded_.
+    std::vector<std::string> strings_;
+
+    /// Values of the static variables declared by the code of this block,
+    /// indexed by slot.
+    std::vector<int> statics_;
+    /// For each slot of statics_, nonzero if the variable was initialized.
+    std::vector<uint8_t> statics_initialized_;
+    /// Translated C++ code of code_, or nullptr if there is none.
+    NativeBlockFn native_{nullptr};
+
+    void clear_decoded() {
+      std::vector<DecodedInsn> d;
+      decoded_.swap(d);
+      std::vector<std::string> s;
+      strings_.swap(s);
+    }
+
+    void clear_statics() {
+      statics_.clear();
+      statics_initialized_.clear();
+    }
   };
 
+  /// Lowers the bytecode of a block into pre-decoded instructions. If the
+  /// bytecode contains anything that the decoder does not understand (unknown
+  /// opcode, truncated operand, jump into the middle of an instruction), the
+  /// decoded form is left empty.
+  /// @param block is the block to decode.
+  void predecode_block(BlockInfo* block);
+
+  /// Looks up which decoded instruction starts at a given byte offset.
+  /// @param insns is the decoded instruction array of a block.
+  /// @param ofs is the byte offset in the bytecode of the block.
+  /// @return the index in insns, or -1 if no instruction starts there.
+  static int find_decoded_insn(const std::vector<DecodedInsn>& insns,
+                               unsigned ofs);
+
   /// All the known / registered blocks.
   std::vector<BlockInfo> blocks_;
   
@@ -292,6 +464,19 @@ class VM {
   /// Output callback.
   std::function<void(std::string)> print_cb_;
 
+  /// Instruction sampler callback for profiling. May be empty.
+  std::function<void(ip_t)> ip_sampler_;
+  /// Number of instructions between two calls to insn_period_expired().
+  uint32_t insn_period_;
+  /// Decremented by every executed instruction.
+  uint32_t insn_countdown_;
+  /// Number of instructions executed before the current countdown started.
+  uint64_t insns_checkpoint_{0};
+  /// Number of reads of external variables.
+  unsigned external_reads_{0};
+  /// Number of writes of external variables.
+  unsigned external_writes_{0};
+
   /// Next instruction to execute.
   const uint8_t* _block_start_;
   /// Next instruction to execute.
@@ -315,8 +500,62 @@ class VM {
   /// True if the last variable access encountered an error. Set by
   /// access_error()
   unsigned access_error_ : 1;
+  /// True if set_block_code should pre-decode the bytecode.
+  unsigned use_predecode_ : 1;
+  /// True if set_block_code should look up translated code for the block.
+  unsigned use_native_ : 1;
+  /// True if all decoded instructions have their handler filled in.
+  unsigned threaded_ : 1;
 };
 
+inline bool VM::indirect_load(const VMVariableReference& ref, int* value) {
+  switch (ref.storage) {
+    case VMVariableReference::OPERAND_STACK:
+      if (ref.arg >= operand_stack_.size()) break;
+      *value = operand_stack_[ref.arg];
+      return true;
+    case VMVariableReference::STATIC_SLOT: {
+      const auto& statics = blocks_[ref.block].statics_;
+      if (ref.arg >= statics.size()) break;
+      *value = statics[ref.arg];
+      return true;
+    }
+    case VMVariableReference::EXTERNAL:
+      ++external_reads_;
+      *value = ref.var->read(variable_factory_, ref.arg);
+      return !access_error_;
+  }
+  access_error();
+  return false;
+}
+
+inline bool VM::indirect_store(const VMVariableReference& ref, int value) {
+  switch (ref.storage) {
+    case VMVariableReference::OPERAND_STACK:
+      if (ref.arg >= operand_stack_.size()) break;
+      operand_stack_[ref.arg] = value;
+      return true;
+    case VMVariableReference::STATIC_SLOT:
+      if (!store_static(ref.block, ref.arg, value)) break;
+      return true;
+    case VMVariableReference::EXTERNAL:
+      ++external_writes_;
+      ref.var->write(variable_factory_, ref.arg, value);
+      return !access_error_;
+  }
+  access_error();
+  return false;
+}
+
+inline bool VM::store_static(unsigned block_num, unsigned slot, int value) {
+  auto& statics = blocks_[block_num].statics_;
+  if (slot >= statics.size()) return false;
+  if (statics[slot] != value) {
+    statics[slot] = value;
+    variable_factory_->variable_changed(block_num);
+  }
+  return true;
+}
 
 } // namespace logic
 
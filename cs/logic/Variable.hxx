@@ -38,7 +38,11 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
 #include <limits.h>
+#include <stdint.h>
+
+#include "utils/Atomic.hxx"
 
 namespace logic {
 
@@ -111,7 +115,10 @@ class Variable {
 /// directly.
 class StaticVariable : public Variable {
  public:
-  StaticVariable() {}
+  /// Constructor.
+  /// @param block_num is the logic block that owns this variable. Changes of
+  /// the value will schedule this block for execution.
+  StaticVariable(unsigned block_num = 0) : block_num_(block_num) {}
 
   /// @return the largest valid state value to write or return from this
   /// variable.
@@ -128,11 +135,11 @@ class StaticVariable : public Variable {
   /// @param parent is the variable factory that created this variable.
   /// @param arg is the index for vector variables, zero if not used.
   /// @param value is the new (desired) state of the variable.
-  void write(const VariableFactory* parent, unsigned arg, int value) override {
-    value_ = value;
-  }
+  void write(const VariableFactory* parent, unsigned arg, int value) override;
 
   int value_{0};
+  /// Logic block that owns this variable.
+  unsigned block_num_;
 };
 
 /// Abstract interface to the component that is responsible for creating the
@@ -153,20 +160,79 @@ class VariableFactory {
 
   /// To be called by the VM.
   /// @param cb will be called by the variable implementations when an access
-  /// error is encountered.
+  /// error is encountered in a block that has no callback of its own.
   virtual void set_access_error_callback(std::function<void()> cb) {
     access_error_cb_ = std::move(cb);
   }
 
+  /// To be called by the VM when several VMs share this factory. Must not be
+  /// called while any block is executing.
+  /// @param block_num is the logic block.
+  /// @param cb will be called by the variable implementations when an access
+  /// error is encountered in this block.
+  void set_block_access_error_callback(unsigned block_num,
+                                       std::function<void()> cb) {
+    if (block_access_error_cb_.size() <= block_num) {
+      block_access_error_cb_.resize(block_num + 1);
+    }
+    block_access_error_cb_[block_num] = std::move(cb);
+  }
+
   /// To be called by variables when a read or write fails.
-  virtual void report_access_error() {
-    if (access_error_cb_) access_error_cb_();
+  /// @param block_num is the logic block that owns the variable.
+  virtual void report_access_error(unsigned block_num) {
+    if (block_num < block_access_error_cb_.size() &&
+        block_access_error_cb_[block_num]) {
+      block_access_error_cb_[block_num]();
+    } else if (access_error_cb_) {
+      access_error_cb_();
+    }
+  }
+
+  /// To be called by variables when their value changes. Marks the logic
+  /// block owning the variable to be executed in the next step. Thread-safe.
+  /// @param block_num is the block which created the variable.
+  void variable_changed(unsigned block_num) const {
+    AtomicHolder h(&lock_);
+    changed_blocks_ |= block_bit(block_num);
+  }
+
+  /// Clears the set of changed blocks.
+  /// @return bitmask of the blocks that had a variable change since the last
+  /// call. See block_bit().
+  uint32_t take_changed_blocks() {
+    AtomicHolder h(&lock_);
+    uint32_t ret = changed_blocks_;
+    changed_blocks_ = 0;
+    return ret;
+  }
+
+  /// @param block_num is a logic block number.
+  /// @return the bit representing this block in the changed blocks
+  /// mask. Blocks 31 and above share the same bit.
+  static uint32_t block_bit(unsigned block_num) {
+    return 1u << (block_num < 31 ? block_num : 31);
   }
 
  private:
   std::function<void()> access_error_cb_;
+  /// Access error callbacks of the blocks, indexed by block number.
+  std::vector<std::function<void()>> block_access_error_cb_;
+  /// Protects changed_blocks_.
+  mutable Atomic lock_;
+  /// Bitmask of blocks which had a variable change. See block_bit().
+  mutable uint32_t changed_blocks_{0};
 };
 
+inline void StaticVariable::write(const VariableFactory* parent, unsigned arg,
+                                  int value) {
+  if (value_ == value) return;
+  value_ = value;
+  if (parent) {
+    parent->variable_changed(block_num_);
+  }
+}
+
 } // namespace logic
 
 #endif // _LOGIC_VARIABLE_HXX_
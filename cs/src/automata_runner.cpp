@@ -76,6 +76,17 @@ AutomataRunner& AutomataRunner::ResetForAutomata(Automata* aut) {
   memset(imported_bits_, 0, sizeof(imported_bits_));
   memset(imported_bit_args_, 0, sizeof(imported_bit_args_));
   imported_bits_[0] = aut->GetTimerBit();
+  skip_row_ = skip_row_end_ = nullptr;
+  if (imports_resolved_ && (size_t)aut->GetId() < resolved_imports_.size()) {
+    const auto& r = resolved_imports_[aut->GetId()];
+    for (const auto& imp : r.initial) {
+      imported_bits_[imp.local_idx] = imp.bit;
+      imported_bit_args_[imp.local_idx] = imp.arg;
+    }
+    skip_row_ = r.rows.data();
+    skip_row_end_ = skip_row_ + r.rows.size();
+    row_imports_ = r.imports.data();
+  }
   return *this;
 }
 
@@ -101,11 +112,479 @@ void AutomataRunner::CreateVarzAndAutomatas() {
         final_ofs);
     last_ofs = final_ofs;
   } while (1);
+  imports_resolved_ = false;
+  skip_row_ = skip_row_end_ = nullptr;
   // This will execute all preamble commands, including the variable create
   // commands.
   Run();
 }
 
+unsigned AutomataRunner::action_length(aut_offset_t offset) {
+  insn_t insn = get_insn(offset);
+  if (insn == _ACT_IMPORT_VAR) return 5;
+  if (insn == _ACT_SET_EVENTID) return 3 + (get_insn(offset + 1) & 7);
+  if (insn == _ACT_DEF_VAR || insn == _ACT_SET_VAR_VALUE) return 3;
+  if ((insn & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) return 2;
+  return 1;
+}
+
+void AutomataRunner::ResolveImports() {
+  resolved_imports_.clear();
+  resolved_imports_.resize(all_automata_.size());
+  imports_resolved_ = true;
+  if (!resolve_imports_) return;
+  for (auto* aut : all_automata_) {
+    if (decoded_start_[aut->GetId()] != NOT_DECODED) {
+      // The decoded rows already refer to the imported bits directly.
+      continue;
+    }
+    // How many import commands write each local variable, saturating at 2.
+    uint8_t num_writers[MAX_IMPORT_VAR] = {0};
+    // Rows that have no conditions and only import commands.
+    vector<aut_offset_t> candidates;
+    aut_offset_t ip = aut->GetStartingOffset();
+    while (insn_t insn = get_insn(ip)) {
+      aut_offset_t endif = ip + 1 + (insn & 0x0f);
+      aut_offset_t endcond = endif + (insn >> 4);
+      bool only_imports = endif == ip + 1 && endcond > endif;
+      for (aut_offset_t a = endif; a < endcond; a += action_length(a)) {
+        insn_t act = get_insn(a);
+        if (act == _ACT_DEF_VAR) {
+          // Declared bits may change while running. Falls back to executing
+          // every import.
+          resolved_imports_.clear();
+          resolved_imports_.resize(all_automata_.size());
+          return;
+        }
+        if (act != _ACT_IMPORT_VAR) {
+          only_imports = false;
+          continue;
+        }
+        uint8_t local_idx = get_insn(a + 1) & 31;
+        if (num_writers[local_idx] < 2) ++num_writers[local_idx];
+      }
+      if (only_imports) candidates.push_back(ip);
+      ip = endcond;
+    }
+    auto& r = resolved_imports_[aut->GetId()];
+    for (aut_offset_t row : candidates) {
+      insn_t insn = get_insn(row);
+      aut_offset_t endcond = row + 1 + (insn >> 4);
+      // Truncated rows and rows importing unknown bits are left to fail at
+      // runtime as usual.
+      bool ok = (endcond - row - 1) % 5 == 0;
+      vector<ResolvedImport> imports;
+      for (aut_offset_t a = row + 1; ok && a < endcond; a += 5) {
+        uint8_t local_idx = get_insn(a + 1);
+        uint16_t arg = ((local_idx >> 5) << 8) | get_insn(a + 2);
+        local_idx &= 31;
+        uint16_t global_ofs = get_insn(a + 3) | (get_insn(a + 4) << 8);
+        auto it = declared_bits_.find(global_ofs);
+        if (it == declared_bits_.end()) {
+          ok = false;
+          break;
+        }
+        imports.push_back({it->second, arg, local_idx});
+      }
+      if (!ok) continue;
+      ResolvedRow rr;
+      rr.offset = row;
+      rr.begin = rr.end = r.imports.size();
+      for (const auto& imp : imports) {
+        // When no other command writes this local variable, the order does
+        // not matter and the import can happen when the automata starts.
+        if (num_writers[imp.local_idx] == 1) {
+          r.initial.push_back(imp);
+        } else {
+          r.imports.push_back(imp);
+          ++rr.end;
+        }
+      }
+      r.rows.push_back(rr);
+    }
+  }
+}
+
+constexpr uint32_t AutomataRunner::NOT_DECODED;
+
+void AutomataRunner::DecodeRules() {
+  decoded_ops_.clear();
+  decoded_bits_.clear();
+  decoded_start_.assign(all_automata_.size(), NOT_DECODED);
+  // Range of decoded_bits_ used by each automata.
+  vector<std::pair<size_t, size_t> > bit_ranges(all_automata_.size());
+  for (auto* aut : all_automata_) {
+    aut->SetDirty(true);
+  }
+  for (auto& it : declared_bits_) {
+    it.second->ClearDependents();
+  }
+  skippable_.assign(all_automata_.size(), false);
+  any_skippable_ = false;
+  rule_counts_.assign(all_automata_.size(), 0);
+  bool has_def_var = false;
+  for (auto* aut : all_automata_) {
+    aut_offset_t ip = aut->GetStartingOffset();
+    uint16_t rows = 0;
+    while (insn_t insn = get_insn(ip)) {
+      aut_offset_t endif = ip + 1 + (insn & 0x0f);
+      aut_offset_t endcond = endif + (insn >> 4);
+      for (aut_offset_t a = endif; a < endcond; a += action_length(a)) {
+        if (get_insn(a) == _ACT_DEF_VAR) has_def_var = true;
+      }
+      ip = endcond;
+      ++rows;
+    }
+    rule_counts_[aut->GetId()] = rows;
+  }
+  if (has_def_var) {
+    // Declared bits may change while running, which would leave stale
+    // pointers in the decoded rows and the sensitivity lists. Falls back to
+    // interpreting and running everything.
+    return;
+  }
+  if (decode_rules_) {
+    for (auto* aut : all_automata_) {
+      uint32_t start = decoded_ops_.size();
+      size_t bits_start = decoded_bits_.size();
+      bool aut_has_def_var = false;
+      if (DecodeAutomata(aut, &aut_has_def_var)) {
+        decoded_start_[aut->GetId()] = start;
+        bit_ranges[aut->GetId()] = {bits_start, decoded_bits_.size()};
+        continue;
+      }
+      decoded_ops_.resize(start);
+      decoded_bits_.resize(bits_start);
+    }
+    decoded_ops_.shrink_to_fit();
+    decoded_bits_.shrink_to_fit();
+  }
+  if (!skip_unchanged_) return;
+  for (auto* aut : all_automata_) {
+    int id = aut->GetId();
+    if (decoded_start_[id] == NOT_DECODED) {
+      skippable_[id] = AddBytecodeSensitivityList(aut);
+    } else {
+      skippable_[id] = AddSensitivityList(aut, decoded_start_[id],
+                                          bit_ranges[id].first,
+                                          bit_ranges[id].second);
+    }
+    if (skippable_[id]) any_skippable_ = true;
+  }
+}
+
+bool AutomataRunner::AddBytecodeSensitivityList(Automata* aut) {
+  // Same rules as AddSensitivityList, applied to the bytecode.
+  vector<DecodedBit> bits;
+  bits.push_back({aut->GetTimerBit(), 0});
+  aut_offset_t ip = aut->GetStartingOffset();
+  while (insn_t insn = get_insn(ip)) {
+    aut_offset_t endif = ip + 1 + (insn & 0x0f);
+    aut_offset_t endcond = endif + (insn >> 4);
+    for (aut_offset_t c = ip + 1; c < endif; ++c) {
+      insn_t cond = get_insn(c);
+      if ((cond & _IF_MISCA_MASK) == _IF_MISCA_BASE) return false;
+      if ((cond & _IF_STATE_MASK) != _IF_STATE &&
+          (cond & _IF_REG_MASK) != _IF_REG &&
+          (cond & _GET_LOCK_MASK) != _GET_LOCK &&
+          (cond & _REL_LOCK_MASK) != _REL_LOCK) {
+        return false;
+      }
+    }
+    for (aut_offset_t a = endif; a < endcond; a += action_length(a)) {
+      if (a + action_length(a) > endcond) return false;
+      insn_t act = get_insn(a);
+      if (act == _ACT_IMPORT_VAR) {
+        uint16_t arg = ((get_insn(a + 1) >> 5) << 8) | get_insn(a + 2);
+        uint16_t global_ofs = get_insn(a + 3) | (get_insn(a + 4) << 8);
+        auto it = declared_bits_.find(global_ofs);
+        if (it == declared_bits_.end()) return false;
+        bits.push_back({it->second, arg});
+      } else if (act == _ACT_SET_EVENTID || act == _ACT_SET_VAR_VALUE ||
+                 (act & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) {
+        return false;
+      } else if ((act & _ACT_STATE_MASK) != _ACT_STATE &&
+                 (act & _ACT_TIMER_MASK) != _ACT_TIMER &&
+                 (act & _ACT_REG_MASK) != _ACT_REG) {
+        return false;
+      }
+    }
+    ip = endcond;
+  }
+  for (const auto& b : bits) {
+    if (!b.bit->AddDependent(b.arg, aut)) return false;
+  }
+  return true;
+}
+
+bool AutomataRunner::AddSensitivityList(Automata* aut, uint32_t start,
+                                        size_t bits_begin, size_t bits_end) {
+  // Registers, global variables and the train speed may change without
+  // anyone telling us, so automatas using them have to run every time.
+  for (const DecodedOp* op = &decoded_ops_[start]; op->kind != DEC_END;
+       ++op) {
+    switch (op->kind) {
+      case DEC_ROW:
+      case DEC_IF_STATE:
+      case DEC_IF_REG:
+      case DEC_GET_LOCK:
+      case DEC_REL_LOCK:
+      case DEC_ACT_STATE:
+      case DEC_ACT_TIMER:
+      case DEC_ACT_REG:
+      case DEC_ACT_IMPORT:
+        break;
+      case DEC_IF_OTHER:
+        if ((op->insn & _IF_REG_MASK) == _IF_REG ||
+            (op->insn & _GET_LOCK_MASK) == _GET_LOCK ||
+            (op->insn & _REL_LOCK_MASK) == _REL_LOCK) {
+          break;
+        }
+        return false;
+      case DEC_ACT_OTHER:
+        if ((op->insn & _ACT_REG_MASK) == _ACT_REG) break;
+        return false;
+      default:
+        return false;
+    }
+  }
+  // Even if a bit refuses, the others keep the automata registered; that
+  // only causes spurious dirty marks.
+  for (size_t i = bits_begin; i < bits_end; ++i) {
+    if (!decoded_bits_[i].bit->AddDependent(decoded_bits_[i].arg, aut)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AutomataRunner::DecodeAutomata(Automata* aut, bool* has_def_var) {
+  // Local variables that are looked up in imported_bits_ when running: those
+  // imported in conditional rows, and those used by instructions that are
+  // evaluated by the interpreter functions.
+  uint32_t dynamic_locals = 0;
+  aut_offset_t ip = aut->GetStartingOffset();
+  while (insn_t insn = get_insn(ip)) {
+    aut_offset_t endif = ip + 1 + (insn & 0x0f);
+    aut_offset_t endcond = endif + (insn >> 4);
+    for (aut_offset_t c = ip + 1; c < endif; ++c) {
+      if ((get_insn(c) & _IF_MISCA_MASK) == _IF_MISCA_BASE) ++c;
+      if (c >= endif) return false;
+    }
+    for (aut_offset_t a = endif; a < endcond; a += action_length(a)) {
+      if (a + action_length(a) > endcond) return false;
+      insn_t act = get_insn(a);
+      if (act == _ACT_DEF_VAR) {
+        *has_def_var = true;
+        return false;
+      }
+      if ((act == _ACT_IMPORT_VAR && endif > ip + 1) ||
+          act == _ACT_SET_VAR_VALUE ||
+          ((act & _ACT_MISCA_MASK) == _ACT_MISCA_BASE &&
+           act != _ACT_SET_EVENTID)) {
+        dynamic_locals |= 1u << (get_insn(a + 1) & 31);
+      }
+    }
+    ip = endcond;
+  }
+  if (ip - aut->GetStartingOffset() > 0xffff) return false;
+
+  static constexpr uint16_t NO_BIT = 0xffff;
+  // Index in decoded_bits_ of the bit imported into each local variable at
+  // the current row, if known.
+  uint16_t local_bits[MAX_IMPORT_VAR];
+  for (auto& b : local_bits) b = NO_BIT;
+  // Appends a bit to decoded_bits_. Returns false if the index does not fit.
+  auto add_bit = [this](ReadWriteBit* bit, uint16_t arg) {
+    if (decoded_bits_.size() >= NO_BIT) return false;
+    decoded_bits_.push_back({bit, arg});
+    return true;
+  };
+  if (!add_bit(aut->GetTimerBit(), 0)) return false;
+  local_bits[0] = decoded_bits_.size() - 1;
+  // @return true if a condition or action on a local variable can be
+  // resolved to a bit.
+  auto resolved = [&](unsigned local_idx) {
+    return local_idx < MAX_IMPORT_VAR &&
+           !(dynamic_locals & (1u << local_idx)) &&
+           local_bits[local_idx] != NO_BIT;
+  };
+  DecodedOp op;
+  ip = aut->GetStartingOffset();
+  while (insn_t insn = get_insn(ip)) {
+    aut_offset_t endif = ip + 1 + (insn & 0x0f);
+    aut_offset_t endcond = endif + (insn >> 4);
+    uint32_t row = decoded_ops_.size();
+    op.kind = DEC_ROW;
+    op.insn = 0;
+    op.arg = 0;
+    decoded_ops_.push_back(op);
+    for (aut_offset_t c = ip + 1; c < endif; ++c) {
+      op.insn = get_insn(c);
+      op.arg = 0;
+      unsigned local_idx = op.insn & _IF_REG_BITNUM_MASK;
+      unsigned lock_idx = op.insn & ~_GET_LOCK_MASK;
+      if ((op.insn & _IF_MISCA_MASK) == _IF_MISCA_BASE) {
+        op.kind = DEC_IF_OTHER2;
+        op.arg = get_insn(++c);
+      } else if ((op.insn & _IF_STATE_MASK) == _IF_STATE) {
+        op.kind = DEC_IF_STATE;
+        op.arg = op.insn & ~_IF_STATE_MASK;
+      } else if ((op.insn & _IF_REG_MASK) == _IF_REG && resolved(local_idx)) {
+        op.kind = DEC_IF_REG;
+        op.arg = local_bits[local_idx];
+      } else if ((op.insn & _GET_LOCK_MASK) == _GET_LOCK &&
+                 resolved(lock_idx)) {
+        op.kind = DEC_GET_LOCK;
+        op.arg = local_bits[lock_idx];
+      } else if ((op.insn & _REL_LOCK_MASK) == _REL_LOCK &&
+                 resolved(lock_idx)) {
+        op.kind = DEC_REL_LOCK;
+        op.arg = local_bits[lock_idx];
+      } else {
+        op.kind = DEC_IF_OTHER;
+      }
+      decoded_ops_.push_back(op);
+      ++decoded_ops_[row].insn;
+    }
+    for (aut_offset_t a = endif; a < endcond; a += action_length(a)) {
+      op.insn = get_insn(a);
+      op.arg = 0;
+      unsigned local_idx = op.insn & _IF_REG_BITNUM_MASK;
+      if (op.insn == _ACT_IMPORT_VAR) {
+        uint8_t local_idx = get_insn(a + 1);
+        uint16_t arg = ((local_idx >> 5) << 8) | get_insn(a + 2);
+        local_idx &= 31;
+        uint16_t global_ofs = get_insn(a + 3) | (get_insn(a + 4) << 8);
+        auto it = declared_bits_.find(global_ofs);
+        if (it == declared_bits_.end()) {
+          // Will fail when running.
+          op.kind = DEC_ACT_BYTECODE;
+          op.arg = a - aut->GetStartingOffset();
+        } else {
+          if (!add_bit(it->second, arg)) return false;
+          if (!(dynamic_locals & (1u << local_idx))) {
+            // Unconditional import; the bit is known for the rest of the
+            // automata.
+            local_bits[local_idx] = decoded_bits_.size() - 1;
+            continue;
+          }
+          op.kind = DEC_ACT_IMPORT;
+          op.insn = local_idx;
+          op.arg = decoded_bits_.size() - 1;
+        }
+      } else if (op.insn == _ACT_SET_EVENTID ||
+                 op.insn == _ACT_SET_VAR_VALUE) {
+        op.kind = DEC_ACT_BYTECODE;
+        op.arg = a - aut->GetStartingOffset();
+      } else if ((op.insn & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) {
+        op.kind = DEC_ACT_OTHER2;
+        op.arg = get_insn(a + 1);
+      } else if ((op.insn & _ACT_STATE_MASK) == _ACT_STATE) {
+        op.kind = DEC_ACT_STATE;
+        op.arg = op.insn & ~_ACT_STATE_MASK;
+      } else if ((op.insn & _ACT_TIMER_MASK) == _ACT_TIMER) {
+        op.kind = DEC_ACT_TIMER;
+        op.arg = op.insn & ~_ACT_TIMER_MASK;
+      } else if ((op.insn & _ACT_REG_MASK) == _ACT_REG &&
+                 resolved(local_idx)) {
+        op.kind = DEC_ACT_REG;
+        op.arg = local_bits[local_idx];
+      } else {
+        op.kind = DEC_ACT_OTHER;
+      }
+      decoded_ops_.push_back(op);
+    }
+    if (decoded_ops_.size() == row + 1) {
+      // Nothing left to do in this row.
+      decoded_ops_.pop_back();
+    } else {
+      decoded_ops_[row].arg = decoded_ops_.size() - row - 1;
+    }
+    ip = endcond;
+  }
+  op.kind = DEC_END;
+  op.insn = 0;
+  op.arg = 0;
+  decoded_ops_.push_back(op);
+  return true;
+}
+
+void AutomataRunner::RunDecoded(uint32_t start) {
+  const DecodedOp* op = decoded_ops_.data() + start;
+  const DecodedBit* bits = decoded_bits_.data();
+  while (op->kind == DEC_ROW) {
+    const DecodedOp* endif = op + 1 + op->insn;
+    const DecodedOp* next = op + 1 + op->arg;
+    ++op;
+    bool keep = true;
+    for (; keep && op < endif; ++op) {
+      switch (op->kind) {
+        case DEC_IF_STATE:
+          keep = current_automata_->GetState() == op->arg;
+          break;
+        case DEC_IF_REG: {
+          const DecodedBit& b = bits[op->arg];
+          keep = b.bit->Read(b.arg, openmrn_node_, current_automata_) ==
+                 !!(op->insn & (1 << 6));
+          break;
+        }
+        case DEC_GET_LOCK: {
+          const DecodedBit& b = bits[op->arg];
+          if (b.bit->Read(b.arg, openmrn_node_, current_automata_)) {
+            keep = false;
+          } else {
+            b.bit->Write(b.arg, openmrn_node_, current_automata_, true);
+          }
+          break;
+        }
+        case DEC_REL_LOCK: {
+          const DecodedBit& b = bits[op->arg];
+          b.bit->Write(b.arg, openmrn_node_, current_automata_, false);
+          break;
+        }
+        case DEC_IF_OTHER2:
+          keep = eval_condition2(op->insn, op->arg);
+          break;
+        default:
+          keep = eval_condition(op->insn);
+          break;
+      }
+    }
+    for (; keep && op < next; ++op) {
+      switch (op->kind) {
+        case DEC_ACT_STATE:
+          current_automata_->SetState(op->arg);
+          break;
+        case DEC_ACT_TIMER:
+          current_automata_->SetTimer(op->arg);
+          break;
+        case DEC_ACT_REG: {
+          const DecodedBit& b = bits[op->arg];
+          b.bit->Write(b.arg, openmrn_node_, current_automata_,
+                       op->insn & (1 << 6));
+          break;
+        }
+        case DEC_ACT_IMPORT:
+          imported_bits_[op->insn] = bits[op->arg].bit;
+          imported_bit_args_[op->insn] = bits[op->arg].arg;
+          break;
+        case DEC_ACT_OTHER2:
+          eval_action2(op->insn, op->arg);
+          break;
+        case DEC_ACT_BYTECODE:
+          ip_ = current_automata_->GetStartingOffset() + op->arg;
+          run_action(ip_ + action_length(ip_));
+          break;
+        default:
+          eval_action(op->insn);
+          break;
+      }
+    }
+    op = next;
+  }
+}
+
 void AutomataRunner::debug_hook() {
   auto print_ip = last_ip_;
   last_ip_ = ip_;
@@ -133,6 +612,19 @@ void AutomataRunner::Run() {
     numact = insn >> 4;
     endif = ip_ + numif;
     endcond = endif + numact;
+    while (skip_row_ != skip_row_end_ && skip_row_->offset < ip_ - 1) {
+      ++skip_row_;
+    }
+    if (skip_row_ != skip_row_end_ && skip_row_->offset == ip_ - 1) {
+      for (unsigned i = skip_row_->begin; i < skip_row_->end; ++i) {
+        const auto& imp = row_imports_[i];
+        imported_bits_[imp.local_idx] = imp.bit;
+        imported_bit_args_[imp.local_idx] = imp.arg;
+      }
+      ++skip_row_;
+      ip_ = endcond;
+      continue;
+    }
     keep = true;
     insn_t insn, arg;
     while (ip_ < endif) {
@@ -158,48 +650,53 @@ void AutomataRunner::Run() {
     }
     while (ip_ < endcond) {
       debug_hook();
-      insn = load_insn();
-      if (insn == _ACT_IMPORT_VAR) {
-        import_variable();
-        if (ip_ > endcond) {
-          diewith(CS_DIE_AUT_TWOBYTEFAIL);
-        }
-      } else if (insn == _ACT_SET_EVENTID) {
-        insn_load_event_id();
-        if (ip_ > endcond) {
-          diewith(CS_DIE_AUT_TWOBYTEFAIL);
-        }
-      } else if (insn == _ACT_DEF_VAR) {
-        int offset = ip_;
-        ReadWriteBit* newbit = create_variable();
-        if (ip_ > endcond) {
-          diewith(CS_DIE_AUT_TWOBYTEFAIL);
-        }
-        delete declared_bits_[offset];
-        declared_bits_[offset] = newbit;
-      } else if (insn == _ACT_SET_VAR_VALUE) {
-        arg = load_insn();
-        int offset = arg >> 5;
-        int var = arg & 31;
-        arg = load_insn();
-        if (ip_ > endcond) {
-          diewith(CS_DIE_AUT_TWOBYTEFAIL);
-        }
-        GetBit(var)->SetState(offset, arg);
-      } else if ((insn & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) {
-        if (ip_ >= endcond) {
-          diewith(CS_DIE_AUT_TWOBYTEFAIL);
-        }
-        arg = load_insn();
-        eval_action2(insn, arg);
-      } else {
-        eval_action(insn);
-      }
+      run_action(endcond);
     }
     debug_hook();
   }
 }
 
+void AutomataRunner::run_action(aut_offset_t endcond) {
+  insn_t arg;
+  insn_t insn = load_insn();
+  if (insn == _ACT_IMPORT_VAR) {
+    import_variable();
+    if (ip_ > endcond) {
+      diewith(CS_DIE_AUT_TWOBYTEFAIL);
+    }
+  } else if (insn == _ACT_SET_EVENTID) {
+    insn_load_event_id();
+    if (ip_ > endcond) {
+      diewith(CS_DIE_AUT_TWOBYTEFAIL);
+    }
+  } else if (insn == _ACT_DEF_VAR) {
+    int offset = ip_;
+    ReadWriteBit* newbit = create_variable();
+    if (ip_ > endcond) {
+      diewith(CS_DIE_AUT_TWOBYTEFAIL);
+    }
+    delete declared_bits_[offset];
+    declared_bits_[offset] = newbit;
+  } else if (insn == _ACT_SET_VAR_VALUE) {
+    arg = load_insn();
+    int offset = arg >> 5;
+    int var = arg & 31;
+    arg = load_insn();
+    if (ip_ > endcond) {
+      diewith(CS_DIE_AUT_TWOBYTEFAIL);
+    }
+    GetBit(var)->SetState(offset, arg);
+  } else if ((insn & _ACT_MISCA_MASK) == _ACT_MISCA_BASE) {
+    if (ip_ >= endcond) {
+      diewith(CS_DIE_AUT_TWOBYTEFAIL);
+    }
+    arg = load_insn();
+    eval_action2(insn, arg);
+  } else {
+    eval_action(insn);
+  }
+}
+
 void AutomataRunner::import_variable() {
   uint8_t local_idx = load_insn();
   uint16_t arg = local_idx >> 5;
@@ -224,21 +721,45 @@ void AutomataRunner::import_variable() {
   imported_bit_args_[local_idx] = arg;
 }
 
+/// A set of automatas to mark dirty when a bit changes.
+class DependentList {
+ public:
+  void add(Automata* aut) {
+    // Automatas usually refer to the same bit in consecutive rows.
+    if (deps_.empty() || deps_.back() != aut) deps_.push_back(aut);
+  }
+
+  void clear() { deps_.clear(); }
+
+  void mark_dirty() {
+    for (auto* aut : deps_) aut->SetDirty(true);
+  }
+
+ private:
+  vector<Automata*> deps_;
+};
+
 class EventBit : public ReadWriteBit {
  public:
   EventBit(openlcb::Node* node, uint64_t event_on, uint64_t event_off,
            uint8_t mask, uint8_t* ptr)
       : bit_(node, event_on, event_off, ptr, mask),
         pc_(&bit_),
-        defined_(false) {
+        defined_(false),
+        last_value_(false) {
     if (0) fprintf(stderr, "event bit create on node %p\n", node);
   }
 
-  void Initialize(openlcb::Node*) override {
-    pc_.SendQuery(&automata_write_helper, get_notifiable());
+  void Initialize(openlcb::Node* node) override {
+    InitializeAsync(node, &automata_write_helper, get_notifiable());
     wait_for_notification();
   }
 
+  void InitializeAsync(openlcb::Node*, openlcb::WriteHelper* helper,
+                       BarrierNotifiable* done) override {
+    pc_.SendQuery(helper, done);
+  }
+
   bool Read(uint16_t, openlcb::Node*, Automata* aut) override {
     // TODO(balazs.racz): we should consider CHECK failing here if
     // !defined. That will force us to explicitly reset every bit in StInit.
@@ -258,6 +779,22 @@ class EventBit : public ReadWriteBit {
     pc_.SendEventReport(&automata_write_helper, get_notifiable());
     wait_for_notification();
     defined_ = true;
+    PollChanges();
+  }
+
+  bool AddDependent(uint16_t, Automata* aut) override {
+    deps_.add(aut);
+    return true;
+  }
+
+  void ClearDependents() override { deps_.clear(); }
+
+  void PollChanges() override {
+    bool value = bit_.get_current_state() == openlcb::EventState::VALID;
+    if (value != last_value_) {
+      last_value_ = value;
+      deps_.mark_dirty();
+    }
   }
 
  private:
@@ -265,6 +802,9 @@ class EventBit : public ReadWriteBit {
   openlcb::BitEventPC pc_;
   // This bit is true if we've already seen an event that defines this bit.
   bool defined_;
+  // Value of the bit at the last PollChanges call.
+  bool last_value_;
+  DependentList deps_;
 };
 
 class EventBlockBit : public ReadWriteBit {
@@ -272,13 +812,18 @@ class EventBlockBit : public ReadWriteBit {
   EventBlockBit(openlcb::WriteHelper::node_type node, uint64_t event_base,
                 size_t size)
       : storage_(new uint32_t[(size + 31) >> 5]),
+        last_storage_(new uint32_t[(size + 31) >> 5]),
+        size_((size + 31) >> 5),
         handler_(
             new openlcb::BitRangeEventPC(node, event_base, storage_, size)) {
-    size_t sz = (size + 31) >> 5;
-    memset(&storage_[0], 0, sz * sizeof(storage_[0]));
+    memset(&storage_[0], 0, size_ * sizeof(storage_[0]));
+    memset(&last_storage_[0], 0, size_ * sizeof(last_storage_[0]));
   }
 
-  ~EventBlockBit() { delete[] storage_; }
+  ~EventBlockBit() {
+    delete[] storage_;
+    delete[] last_storage_;
+  }
 
   bool Read(uint16_t arg, openlcb::Node*, Automata* aut) override {
     return handler_->Get(arg);
@@ -287,16 +832,49 @@ class EventBlockBit : public ReadWriteBit {
   void Write(uint16_t arg, openlcb::Node*, Automata* aut, bool value) override {
     handler_->Set(arg, value, &automata_write_helper, get_notifiable());
     wait_for_notification();
+    PollChanges();
   }
 
-  void Initialize(openlcb::Node*) OVERRIDE {
-    handler_->SendIdentified(&automata_write_helper, get_notifiable());
+  void Initialize(openlcb::Node* node) OVERRIDE {
+    InitializeAsync(node, &automata_write_helper, get_notifiable());
     wait_for_notification();
   }
 
+  void InitializeAsync(openlcb::Node*, openlcb::WriteHelper* helper,
+                       BarrierNotifiable* done) override {
+    handler_->SendIdentified(helper, done);
+  }
+
+  bool AddDependent(uint16_t arg, Automata* aut) override {
+    deps_[arg].add(aut);
+    return true;
+  }
+
+  void ClearDependents() override { deps_.clear(); }
+
+  void PollChanges() override {
+    if (deps_.empty()) return;
+    for (unsigned i = 0; i < size_; ++i) {
+      uint32_t value = storage_[i];
+      uint32_t diff = value ^ last_storage_[i];
+      if (!diff) continue;
+      last_storage_[i] = value;
+      for (auto it = deps_.lower_bound(i << 5);
+           it != deps_.end() && it->first < ((i + 1) << 5); ++it) {
+        if (diff & (1U << (it->first & 31))) it->second.mark_dirty();
+      }
+    }
+  }
+
  private:
   uint32_t* storage_;
+  // Copy of storage_ at the last PollChanges call.
+  uint32_t* last_storage_;
+  // Number of words in storage_.
+  unsigned size_;
   std::unique_ptr<openlcb::BitRangeEventPC> handler_;
+  // Automatas to mark dirty, indexed by the bit number.
+  std::map<uint16_t, DependentList> deps_;
 };
 
 class EventByteBlock : public ReadWriteBit {
@@ -327,11 +905,16 @@ class EventByteBlock : public ReadWriteBit {
     }
   }
 
-  void Initialize(openlcb::Node*) OVERRIDE {
-    handler_->SendIdentified(&automata_write_helper, get_notifiable());
+  void Initialize(openlcb::Node* node) OVERRIDE {
+    InitializeAsync(node, &automata_write_helper, get_notifiable());
     wait_for_notification();
   }
 
+  void InitializeAsync(openlcb::Node*, openlcb::WriteHelper* helper,
+                       BarrierNotifiable* done) override {
+    handler_->SendIdentified(helper, done);
+  }
+
  private:
   uint8_t* storage_;
   std::unique_ptr<openlcb::ByteRangeEventP> handler_;
@@ -361,11 +944,16 @@ class EventByteBlockConsumer : public ReadWriteBit {
     storage_[arg] = state;
   }
 
-  void Initialize(openlcb::Node*) OVERRIDE {
-    handler_->SendIdentified(&automata_write_helper, get_notifiable());
+  void Initialize(openlcb::Node* node) OVERRIDE {
+    InitializeAsync(node, &automata_write_helper, get_notifiable());
     wait_for_notification();
   }
 
+  void InitializeAsync(openlcb::Node*, openlcb::WriteHelper* helper,
+                       BarrierNotifiable* done) override {
+    handler_->SendIdentified(helper, done);
+  }
+
  private:
   uint8_t* storage_;
   std::unique_ptr<openlcb::ByteRangeEventC> handler_;
@@ -402,6 +990,7 @@ ReadWriteBit* AutomataRunner::create_variable() {
 void AutomataRunner::InjectBit(aut_offset_t offset, ReadWriteBit* bit) {
   delete declared_bits_[offset];
   declared_bits_[offset] = bit;
+  imports_resolved_ = false;
 }
 
 void AutomataRunner::insn_load_event_id() {
@@ -709,6 +1298,9 @@ void AutomataRunner::eval_action2(insn_t insn, insn_t arg) {
 }
 
 bool AutomataRunner::set_train_speed(openlcb::Velocity v) {
+  if (traction_) {
+    traction_->update_speed(aut_eventids_[0], v);
+  }
   auto* b = openmrn_node_->iface()->addressed_message_write_flow()->alloc();
   b->data()->reset(openlcb::Defs::MTI_TRACTION_CONTROL_COMMAND,
                    openmrn_node_->node_id(),
@@ -718,17 +1310,62 @@ bool AutomataRunner::set_train_speed(openlcb::Velocity v) {
   return true;
 }
 
+DECLARE_CONST(automata_train_speed_max_age_msec);
+
 openlcb::Velocity AutomataRunner::get_train_speed() {
   HASSERT(traction_.get());
+  openlcb::NodeID train = aut_eventids_[0];
+  long long now = os_get_time_monotonic();
+  openlcb::Velocity ret = openlcb::nan_to_speed();
+  bool known = false;
+  bool query = false;
+  {
+    OSMutexLock l(&traction_->lock_);
+    auto it = traction_->speeds_.find(train);
+    if (it != traction_->speeds_.end()) {
+      known = true;
+      auto& e = it->second;
+      if (e.updated &&
+          now - e.updated <
+              MSEC_TO_NSEC(config_automata_train_speed_max_age_msec())) {
+        ret = e.speed;
+      }
+      // Only one query in flight at a time, unless it timed out.
+      bool pending =
+          e.queried > e.updated && now - e.queried < MSEC_TO_NSEC(100);
+      if (now - e.updated >= traction_->refresh_nsec_ && !pending) {
+        e.queried = now;
+        query = true;
+      }
+    } else {
+      traction_->speeds_[train].queried = now;
+    }
+  }
+  if (!known) {
+    // First time we see this train.
+    ret = query_train_speed(train);
+    if (!ret.isnan()) {
+      traction_->update_speed(train, ret);
+    }
+  } else if (query) {
+    send_speed_query(train);
+  }
+  return ret;
+}
+
+void AutomataRunner::send_speed_query(openlcb::NodeID train) {
   auto* b = openmrn_node_->iface()->addressed_message_write_flow()->alloc();
   b->data()->reset(openlcb::Defs::MTI_TRACTION_CONTROL_COMMAND,
-                   openmrn_node_->node_id(),
-                   {aut_eventids_[0], 0},
+                   openmrn_node_->node_id(), {train, 0},
+                   openlcb::TractionDefs::speed_get_payload());
+  openmrn_node_->iface()->addressed_message_write_flow()->send(b);
+}
+
+openlcb::Velocity AutomataRunner::query_train_speed(openlcb::NodeID train) {
+  auto* b = openmrn_node_->iface()->addressed_message_write_flow()->alloc();
+  b->data()->reset(openlcb::Defs::MTI_TRACTION_CONTROL_COMMAND,
+                   openmrn_node_->node_id(), {train, 0},
                    openlcb::TractionDefs::speed_get_payload());
-  /** @TODO(balazs.racz) This timeout is way too long -- we want to run
-   * automatas at 10 Hz. We really should not block the current thread for so
-   * long. Ideally of course this response would arrive much faster, like
-   * within a msec if local CS, or a few msecs if remote. */
   traction_->timer_.start(MSEC_TO_NSEC(100));
   traction_->resp_handler_.wait_for_response(b->data()->dst,
                                              b->data()->payload[0],
@@ -739,20 +1376,47 @@ openlcb::Velocity AutomataRunner::get_train_speed() {
   if (!traction_->resp_handler_.response()) {
     LOG(VERBOSE,
         "automata: Timeout waiting for traction response from 0x%016" PRIx64
-        ".", aut_eventids_[0]);
+        ".", train);
     return openlcb::nan_to_speed();
   } else {
     openlcb::Velocity r;
     if (!openlcb::TractionDefs::speed_get_parse_last(
              traction_->resp_handler_.response()->data()->payload, &r)) {
       LOG(WARNING, "automata: Invalid traction response from 0x%016" PRIx64 ".",
-          aut_eventids_[0]);
+          train);
       return openlcb::nan_to_speed();
     }
     return r;
   }
 }
 
+void AutomataRunner::Traction::update_speed(openlcb::NodeID train,
+                                            openlcb::Velocity speed) {
+  OSMutexLock l(&lock_);
+  auto it = speeds_.find(train);
+  if (it == speeds_.end()) return;
+  it->second.speed = speed;
+  it->second.updated = os_get_time_monotonic();
+}
+
+void AutomataRunner::Traction::handle_message(
+    Buffer<openlcb::GenMessage>* b) {
+  auto bd = get_buffer_deleter(b);
+  const openlcb::Payload& p = b->data()->payload;
+  if (p.size() < 3) return;
+  openlcb::Velocity v;
+  if (b->data()->mti == openlcb::Defs::MTI_TRACTION_CONTROL_REPLY) {
+    if (p[0] != openlcb::TractionDefs::RESP_QUERY_SPEED ||
+        !openlcb::TractionDefs::speed_get_parse_last(p, &v)) {
+      return;
+    }
+    update_speed(b->data()->src.id, v);
+  } else if ((p[0] & 0x7f) == openlcb::TractionDefs::REQ_SET_SPEED) {
+    v.set_wire((((uint8_t)p[1]) << 8) | (uint8_t)p[2]);
+    update_speed(b->data()->dst.id, v);
+  }
+}
+
 void AutomataRunner::WaitForWakeup() { os_sem_wait(&automata_sem_); }
 
 void AutomataRunner::TriggerRun() { os_sem_post(&automata_sem_); }
@@ -764,15 +1428,64 @@ void AutomataRunner::AddPendingTick() {
 }
 
 void AutomataRunner::RunAllAutomata() {
+  if (!imports_resolved_) {
+    DecodeRules();
+    ResolveImports();
+  }
   if (pending_ticks_) {
     for (auto* aut : all_automata_) {
       aut->Tick();
     }
     --pending_ticks_;
   }
+  if (any_skippable_) {
+    // Only needed for marking the skippable automatas dirty.
+    for (auto& it : declared_bits_) {
+      it.second->PollChanges();
+    }
+  }
   for (auto* aut : all_automata_) {
-    ResetForAutomata(aut).Run();
+    ++num_runs_;
+    if ((size_t)aut->GetId() < skippable_.size() &&
+        skippable_[aut->GetId()] && !aut->IsDirty()) {
+      ++num_skipped_;
+      continue;
+    }
+    // Changes made while running mark the automata dirty again.
+    aut->SetDirty(false);
+    if ((size_t)aut->GetId() < rule_counts_.size()) {
+      num_rules_ += rule_counts_[aut->GetId()];
+    }
+    ResetForAutomata(aut);
+    uint32_t start = NOT_DECODED;
+    if ((size_t)aut->GetId() < decoded_start_.size() &&
+        !g_aut_debug_space.logEventId_) {
+      // The debug hook needs the bytecode offsets.
+      start = decoded_start_[aut->GetId()];
+    }
+    if (start != NOT_DECODED) {
+      RunDecoded(start);
+    } else {
+      Run();
+    }
+  }
+  LogSkipStats();
+}
+
+void AutomataRunner::LogSkipStats() {
+  long long now = os_get_time_monotonic();
+  if (!last_log_time_) {
+    last_log_time_ = now;
+    return;
   }
+  if (now - last_log_time_ < SEC_TO_NSEC(60)) return;
+  unsigned sec = (now - last_log_time_) / SEC_TO_NSEC(1);
+  LOG(INFO, "automata: skipped %u of %u evaluations per second",
+      (num_skipped_ - last_log_skipped_) / sec,
+      (num_runs_ - last_log_runs_) / sec);
+  last_log_runs_ = num_runs_;
+  last_log_skipped_ = num_skipped_;
+  last_log_time_ = now;
 }
 
 DECLARE_CONST(automata_init_backoff);
@@ -783,15 +1496,38 @@ void AutomataRunner::InitializeState() {
   }
   // This is only called when running with_thread.
   CreateVarzAndAutomatas();
-  for (auto it : declared_bits_) {
-    it.second->Initialize(openmrn_node_);
-    do {
-      usleep(config_automata_init_backoff());
-    } while (openlcb::EventService::instance->event_processing_pending());
-  }
+  QueryBitStates();
   pending_ticks_ = 0;
 }
 
+DECLARE_CONST(automata_init_window);
+
+void AutomataRunner::QueryBitStates() {
+  unsigned window = config_automata_init_window();
+  if (!window) window = 1;
+  // Each write helper can only send one message at a time.
+  std::unique_ptr<openlcb::WriteHelper[]> helpers(
+      new openlcb::WriteHelper[window]);
+  for (unsigned i = 0; i < window; ++i) {
+    helpers[i].set_wait_for_local_loopback(true);
+  }
+  auto it = declared_bits_.begin();
+  while (it != declared_bits_.end()) {
+    BarrierNotifiable* done = get_notifiable();
+    for (unsigned i = 0; i < window && it != declared_bits_.end();
+         ++i, ++it) {
+      it->second->InitializeAsync(openmrn_node_, &helpers[i],
+                                  done->new_child());
+    }
+    done->notify();
+    wait_for_notification();
+  }
+  // The responses to all queries are handled together.
+  do {
+    usleep(config_automata_init_backoff());
+  } while (openlcb::EventService::instance->event_processing_pending());
+}
+
 class AutomataTick : public Timer {
  public:
   AutomataTick(AutomataRunner* runner)
@@ -865,9 +1601,31 @@ void* automata_thread(void* arg) {
   return NULL;
 }
 
+DECLARE_CONST(automata_train_speed_refresh_msec);
+
 AutomataRunner::Traction::Traction(openlcb::Node* node)
-    : resp_handler_(node->iface(), node),
-      timer_(node->iface()->executor()->active_timers()) {}
+    : node_(node),
+      refresh_nsec_(MSEC_TO_NSEC(config_automata_train_speed_refresh_msec())),
+      resp_handler_(node->iface(), node),
+      timer_(node->iface()->executor()->active_timers()) {
+  node_->iface()->dispatcher()->register_handler(
+      &handler_, openlcb::Defs::MTI_TRACTION_CONTROL_COMMAND,
+      openlcb::Defs::MTI_EXACT);
+  node_->iface()->dispatcher()->register_handler(
+      &handler_, openlcb::Defs::MTI_TRACTION_CONTROL_REPLY,
+      openlcb::Defs::MTI_EXACT);
+}
+
+AutomataRunner::Traction::~Traction() {
+  node_->iface()->dispatcher()->unregister_handler(
+      &handler_, openlcb::Defs::MTI_TRACTION_CONTROL_COMMAND,
+      openlcb::Defs::MTI_EXACT);
+  node_->iface()->dispatcher()->unregister_handler(
+      &handler_, openlcb::Defs::MTI_TRACTION_CONTROL_REPLY,
+      openlcb::Defs::MTI_EXACT);
+}
+
+DECLARE_CONST(automata_decode_rules);
 
 AutomataRunner::AutomataRunner(openlcb::Node* node, const insn_t* base_pointer,
                                bool with_thread)
@@ -876,6 +1634,20 @@ AutomataRunner::AutomataRunner(openlcb::Node* node, const insn_t* base_pointer,
       aut_trainid_(254),
       aut_signal_aspect_(254),
       base_pointer_(base_pointer),
+      decode_rules_(config_automata_decode_rules()),
+      skip_unchanged_(true),
+      any_skippable_(false),
+      num_runs_(0),
+      num_skipped_(0),
+      num_rules_(0),
+      last_log_runs_(0),
+      last_log_skipped_(0),
+      last_log_time_(0),
+      imports_resolved_(false),
+      resolve_imports_(true),
+      skip_row_(nullptr),
+      skip_row_end_(nullptr),
+      row_imports_(nullptr),
       current_automata_(NULL),
       openmrn_node_(node),
       traction_(node ? new Traction(node) : nullptr),
@@ -923,6 +1695,8 @@ void AutomataRunner::Stop(Notifiable* n, bool request_exit) {
         delete i.second;
       }
       declared_bits_.clear();
+      resolved_imports_.clear();
+      imports_resolved_ = false;
       n->notify();
     });
     if (run_state_ == RunState::NO_THREAD) {
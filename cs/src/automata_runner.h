@@ -18,6 +18,7 @@ using std::vector;
 
 #include "openlcb/Velocity.hxx"
 #include "openlcb/TractionClient.hxx"
+#include "openlcb/WriteHelper.hxx"
 #include "executor/Timer.hxx"
 #include "os/OS.hxx"
 
@@ -43,6 +44,26 @@ public:
   virtual uint8_t GetState(uint16_t arg) { HASSERT(0); return 0; }
   virtual void SetState(uint16_t arg, uint8_t state) { HASSERT(0); }
   virtual void Initialize(openlcb::Node* node) = 0;
+  //! Starts sending the messages that learn the state of this bit from the
+  //! network, without waiting for them to go out.
+  //! @param helper may be used to send one message.
+  //! @param done will be notified when the message is sent.
+  virtual void InitializeAsync(openlcb::Node* node, openlcb::WriteHelper* helper,
+                               BarrierNotifiable* done) {
+    Initialize(node);
+    done->notify();
+  }
+
+  //! Registers an automata to be marked dirty when the value of this bit
+  //! with arg changes.
+  //! @return false if this bit cannot report changes. The automata then has
+  //! to be run every time.
+  virtual bool AddDependent(uint16_t arg, Automata* aut) { return false; }
+  //! Forgets all automatas registered with AddDependent.
+  virtual void ClearDependents() {}
+  //! Marks the dependent automatas dirty if the bit changed since the last
+  //! call. Called on the automata thread before running the automatas.
+  virtual void PollChanges() {}
 };
 
 
@@ -66,6 +87,7 @@ public:
         if (debug_variables > 1) {
             LOG(VERBOSE, "Automata %d state to %d", timer_bit_.GetId(), state);
         }
+        if (timer_bit_.state_ != state) dirty_ = true;
 	timer_bit_.state_ = state;
     }
 
@@ -75,15 +97,25 @@ public:
 
     void SetTimer(uint8_t value) {
       if (value == (0xff & (~_ACT_TIMER_MASK))) {
-	    timer_bit_.timer_ = GetId() >> 3;
-      } else {
-	timer_bit_.timer_ = value;
+        value = GetId() >> 3;
       }
+      if (timer_bit_.timer_ != value) dirty_ = true;
+      timer_bit_.timer_ = value;
     }
 
     // Decreases any pending timer by one.
     void Tick() {
-	if (timer_bit_.timer_) --timer_bit_.timer_;
+      if (timer_bit_.timer_ && !--timer_bit_.timer_) dirty_ = true;
+    }
+
+    //! @return true if the state, the timer or any of the input bits of this
+    //! automata may have changed since it was last run.
+    bool IsDirty() {
+      return dirty_;
+    }
+
+    void SetDirty(bool dirty) {
+      dirty_ = dirty;
     }
 
     int GetId() {
@@ -108,6 +140,10 @@ private:
 	    diewith(CS_DIE_AUT_WRITETIMERBIT);
 	}
         void Initialize(openlcb::Node*) OVERRIDE {}
+        bool AddDependent(uint16_t, Automata* aut) override {
+            // Changes are tracked by the automata owning the timer.
+            return aut->GetTimerBit() == this;
+        }
 	int GetId() {
 	    return id_;
 	}
@@ -123,6 +159,8 @@ private:
 
     TimerBit timer_bit_;
     aut_offset_t starting_offset_;
+    //! True if the automata needs to be run.
+    bool dirty_{true};
 };
 
 
@@ -173,6 +211,11 @@ public:
     /// Sends out query messages for every bit.
     void InitializeState();
 
+    /// Queries the state of every declared bit from the network, with
+    /// config_automata_init_window() queries in flight at a time, then waits
+    /// for the responses to be processed.
+    void QueryBitStates();
+
   //===============Accessors for testing================
 
   //! Injects a new ReadWriteBit into the global bits that are known by this
@@ -184,6 +227,54 @@ public:
   //! runner object.
   void InjectBit(aut_offset_t offset, ReadWriteBit* bit);
 
+  //! Sets whether the unconditional imports of the automatas should be
+  //! resolved once before the first run instead of being executed in every
+  //! run. Only applies to automatas that are interpreted; decoded automatas
+  //! need no separate import tables. Default is on. Useful for comparing the
+  //! two in unittests.
+  void SetResolveImports(bool enabled) {
+    resolve_imports_ = enabled;
+    imports_resolved_ = false;
+  }
+
+  //! Sets whether the automatas should be run from a rule table that is
+  //! decoded once from the bytecode before the first run. The default comes
+  //! from the automata_decode_rules constant. When off, or for automatas that
+  //! cannot be decoded, the bytecode is interpreted in every run. Useful for
+  //! comparing the two in unittests.
+  void SetDecodeRules(bool enabled) {
+    decode_rules_ = enabled;
+    imports_resolved_ = false;
+  }
+
+  //! Sets whether automatas that have only bits reporting changes as inputs
+  //! should be skipped when none of their inputs, their state or timer
+  //! changed since their last run. Default is on. Useful for comparing
+  //! against running everything in unittests.
+  void SetSkipUnchanged(bool enabled) {
+    skip_unchanged_ = enabled;
+    imports_resolved_ = false;
+  }
+
+  //! @return how many times an automata was skipped by RunAllAutomata
+  //! because its inputs did not change.
+  unsigned GetSkippedRuns() { return num_skipped_; }
+
+  //! @return how many times an automata was run by RunAllAutomata.
+  unsigned GetEvaluatedRuns() { return num_runs_ - num_skipped_; }
+
+  //! @return how many rules (rows) were evaluated by RunAllAutomata.
+  uint64_t GetEvaluatedRules() { return num_rules_; }
+
+  //! Sets how old a cached train speed may get before it is queried again
+  //! from the train. This bounds how stale the speed of a remote train can
+  //! be, because commands sent to it by other nodes are not seen. Useful for
+  //! unittests.
+  void SetTrainSpeedRefresh(long long refresh_nsec) {
+    HASSERT(traction_);
+    traction_->refresh_nsec_ = refresh_nsec;
+  }
+
   // Testing only - Returns detected list of automatas.
   const vector<Automata*>& GetAllAutomatas() {
     return all_automata_;
@@ -224,6 +315,57 @@ private:
     // arguments.
     //! Evaluates an ACT_IMPORT_VAR
     void import_variable();
+
+    //! Finds the rows of each automata that contain only unconditional
+    //! import commands, and fills in resolved_imports_ with the bits they
+    //! import. These rows are not decoded anymore when running the automatas.
+    void ResolveImports();
+
+    //! @return the length of the action instruction at offset, including
+    //! the arguments.
+    unsigned action_length(aut_offset_t offset);
+
+    //! Evaluates the action instruction at ip_, reading its arguments with
+    //! load_insn(). Dies if the arguments extend beyond endcond.
+    void run_action(aut_offset_t endcond);
+
+    //! Decodes the rows of every automata into decoded_ops_. Bits that are
+    //! imported unconditionally get resolved into the decoded instructions.
+    //! Also computes which automatas can be skipped, for the decoded and the
+    //! interpreted ones alike.
+    void DecodeRules();
+
+    //! Appends the decoded rows of an automata to decoded_ops_.
+    //! @param has_def_var will be set to true if the automata declares
+    //! variables.
+    //! @return false if the automata has to be interpreted from the bytecode.
+    bool DecodeAutomata(Automata* aut, bool* has_def_var);
+
+    //! Periodically logs how many automata evaluations were skipped.
+    void LogSkipStats();
+
+    //! Registers aut as a dependent of all bits it reads, if the decoded
+    //! instructions show that only these bits, its state and timer affect
+    //! the result of running the automata.
+    //! @param start is the index of the first row of the automata in
+    //! decoded_ops_.
+    //! @param bits_begin, bits_end are the range of decoded_bits_ belonging
+    //! to the automata.
+    //! @return true if aut can be skipped when it is not dirty.
+    bool AddSensitivityList(Automata* aut, uint32_t start, size_t bits_begin,
+                            size_t bits_end);
+
+    //! Same as AddSensitivityList for an automata that is interpreted,
+    //! based on its bytecode.
+    //! @return true if aut can be skipped when it is not dirty.
+    bool AddBytecodeSensitivityList(Automata* aut);
+
+    //! Simulates the current automata from the decoded rule table until the
+    //! end of the automata.
+    //! @param start is the index of the first row of the automata in
+    //! decoded_ops_.
+    void RunDecoded(uint32_t start);
+
     //! Evaluates an ACT_DEF_VAR. Returns a new variable. Uses load_insn() to
     //! read arguments.
     ReadWriteBit* create_variable();
@@ -231,10 +373,19 @@ private:
     //! Changes one of the eventid accumulators.
     void insn_load_event_id();
 
-    /** @returns the last commanded speed of the current loco, or NAN if there
-     * was an error getting the speed. */
+    /** @returns the last known speed of the current loco from the speed
+     * cache, or NAN if the speed is not known. Only blocks when the loco is
+     * not yet in the cache; otherwise refreshes stale entries in the
+     * background. */
     openlcb::Velocity get_train_speed();
 
+    /** Queries the speed of a loco and blocks until the response arrives.
+     * @returns the speed, or NAN if there was an error getting the speed. */
+    openlcb::Velocity query_train_speed(openlcb::NodeID train);
+
+    /** Sends a speed query to a loco without waiting for the response. */
+    void send_speed_query(openlcb::NodeID train);
+
     /** Sets the speed of the current loco.
      * @returns true on success. */
     bool set_train_speed(openlcb::Velocity speed);
@@ -266,15 +417,170 @@ private:
     //! Arguments to the imported bits.
     uint16_t imported_bit_args_[MAX_IMPORT_VAR];
 
+    //! An import command that was executed ahead of time.
+    struct ResolvedImport {
+      //! The bit to import.
+      ReadWriteBit* bit;
+      //! Argument to the imported bit.
+      uint16_t arg;
+      //! Local variable index to import into.
+      uint8_t local_idx;
+    };
+    //! A row of an automata that has only unconditional imports.
+    struct ResolvedRow {
+      //! Offset of the row's first instruction.
+      aut_offset_t offset;
+      //! Range in ResolvedImports::imports to apply when reaching this row.
+      uint16_t begin;
+      uint16_t end;
+    };
+    //! Imports of an automata that were executed ahead of time.
+    struct ResolvedImports {
+      //! Imports into local variables that are not imported anywhere else in
+      //! the automata. These get applied when the automata is reset for
+      //! running.
+      vector<ResolvedImport> initial;
+      //! Imports that get applied when their row is reached.
+      vector<ResolvedImport> imports;
+      //! Rows with only unconditional imports, in increasing offset
+      //! order. These are not decoded when running.
+      vector<ResolvedRow> rows;
+    };
+    //! Resolved imports for each automata, indexed by automata id. Valid
+    //! only if imports_resolved_ is true.
+    vector<ResolvedImports> resolved_imports_;
+    //! Kinds of decoded instructions.
+    enum DecodedKind : uint8_t {
+      //! Beginning of a row. insn is the number of conditions, arg is the
+      //! number of conditions and actions that follow.
+      DEC_ROW,
+      //! End of the automata.
+      DEC_END,
+      //! Condition on the automata state in arg.
+      DEC_IF_STATE,
+      //! Conditions on the bit at index arg in decoded_bits_.
+      DEC_IF_REG,
+      DEC_GET_LOCK,
+      DEC_REL_LOCK,
+      //! Condition evaluated by eval_condition(insn).
+      DEC_IF_OTHER,
+      //! Condition evaluated by eval_condition2(insn, arg).
+      DEC_IF_OTHER2,
+      //! Sets the automata state to arg.
+      DEC_ACT_STATE,
+      //! Sets the automata timer to arg.
+      DEC_ACT_TIMER,
+      //! Writes the bit at index arg in decoded_bits_.
+      DEC_ACT_REG,
+      //! Imports the bit at index arg in decoded_bits_ into local variable
+      //! insn.
+      DEC_ACT_IMPORT,
+      //! Action evaluated by eval_action(insn).
+      DEC_ACT_OTHER,
+      //! Action evaluated by eval_action2(insn, arg).
+      DEC_ACT_OTHER2,
+      //! Action executed from the bytecode at arg bytes after the start of
+      //! the automata.
+      DEC_ACT_BYTECODE,
+    };
+    //! A pre-decoded row header, condition or action.
+    struct DecodedOp {
+      DecodedKind kind;
+      //! The original instruction.
+      insn_t insn;
+      uint16_t arg;
+    };
+    //! A bit that a decoded instruction refers to.
+    struct DecodedBit {
+      ReadWriteBit* bit;
+      //! Argument to the bit.
+      uint16_t arg;
+    };
+    //! Marks an automata in decoded_start_ that has no decoded rows.
+    static constexpr uint32_t NOT_DECODED = 0xffffffffu;
+    //! Decoded rows of all automatas.
+    vector<DecodedOp> decoded_ops_;
+    //! Bits referred to by decoded_ops_.
+    vector<DecodedBit> decoded_bits_;
+    //! Index of the first row of each automata in decoded_ops_, indexed by
+    //! automata id.
+    vector<uint32_t> decoded_start_;
+    //! True if the automatas should be run from decoded_ops_.
+    bool decode_rules_;
+    //! Indexed by automata id; true for automatas that can be skipped when
+    //! they are not dirty.
+    vector<bool> skippable_;
+    //! True if unchanged automatas should be skipped.
+    bool skip_unchanged_;
+    //! True if any entry of skippable_ is true.
+    bool any_skippable_;
+    //! How many times RunAllAutomata ran or skipped an automata.
+    unsigned num_runs_;
+    unsigned num_skipped_;
+    //! Number of rows in each automata, indexed by automata id.
+    vector<uint16_t> rule_counts_;
+    //! Number of rows of the automatas that RunAllAutomata ran.
+    uint64_t num_rules_;
+    //! Values of num_runs_ and num_skipped_ at the last statistics log, and
+    //! when that happened.
+    unsigned last_log_runs_;
+    unsigned last_log_skipped_;
+    long long last_log_time_;
+
+    //! True if resolved_imports_ and decoded_ops_ are up-to-date with the
+    //! program and the declared bits.
+    bool imports_resolved_;
+    //! True if imports should be resolved ahead of time.
+    bool resolve_imports_;
+    //! The next resolved row of the current automata. Points into
+    //! resolved_imports_.
+    const ResolvedRow* skip_row_;
+    //! End of the resolved rows of the current automata.
+    const ResolvedRow* skip_row_end_;
+    //! Imports of the resolved rows of the current automata.
+    const ResolvedImport* row_imports_;
+
     //! Points to the current automata.
     Automata* current_automata_;
     //! The OpenMRN node used for generating sourced events.
     openlcb::Node* openmrn_node_;
     struct Traction {
         Traction(openlcb::Node* node);
+        ~Traction();
+
+        //! Last known speed of a train.
+        struct SpeedEntry {
+            openlcb::Velocity speed;
+            //! When speed was last updated, or 0 if it is not known.
+            long long updated{0};
+            //! When the last speed query was sent.
+            long long queried{0};
+        };
+
+        //! Updates the speed cache from traction commands and replies seen
+        //! on the interface. The interface only delivers addressed messages
+        //! whose destination is a local node. The cache thus sees the set
+        //! speed commands to trains hosted on this node and the replies to
+        //! our own speed queries, but not the commands that other throttles
+        //! send to remote trains. Such speed changes are only picked up
+        //! when the entry is refreshed by a query.
+        void handle_message(Buffer<openlcb::GenMessage>* b);
+        //! Records speed as the current speed of train, if the train is in
+        //! the cache.
+        void update_speed(openlcb::NodeID train, openlcb::Velocity speed);
+
+        openlcb::Node* node_;
+        //! Cached speeds older than this many nsec get refreshed.
+        long long refresh_nsec_;
         //! Helper flow for traction requests.
         openlcb::TractionResponseHandler resp_handler_;
         SyncTimeout timer_;
+        //! Protects speeds_.
+        OSMutex lock_;
+        //! Speed cache for the trains that the automatas asked about.
+        map<openlcb::NodeID, SpeedEntry> speeds_;
+        openlcb::MessageHandler::GenericHandler handler_{
+            this, &Traction::handle_message};
     };
     std::unique_ptr<Traction> traction_;
 
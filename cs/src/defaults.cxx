@@ -1,3 +1,16 @@
 #include "utils/constants.hxx"
 
 DEFAULT_CONST(automata_init_backoff, 3000);
+// How many state queries the automata runner sends at startup before waiting
+// for them to go out.
+DEFAULT_CONST(automata_init_window, 16);
+// Decoding the automatas into a rule table takes 4 bytes of RAM per
+// instruction and 8 bytes per import (about 50 kbytes for layout6a), so it is
+// off by default and the bytecode is interpreted. Hosts can turn it on for
+// speed.
+DEFAULT_CONST(automata_decode_rules, 0);
+// Cached train speeds older than this are refreshed in the background. Speed
+// changes that other nodes make to remote trains are only noticed this way.
+DEFAULT_CONST(automata_train_speed_refresh_msec, 250);
+// Cached train speeds older than this are treated as unknown.
+DEFAULT_CONST(automata_train_speed_max_age_msec, 2000);
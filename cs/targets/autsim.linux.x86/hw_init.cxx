@@ -0,0 +1,4 @@
+#include "can_frame.h"
+
+//extern const unsigned long long NODE_ADDRESS;
+//const unsigned long long NODE_ADDRESS = 0x050101011430ULL;
@@ -0,0 +1,384 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Headless simulator for rendered automata programs. Runs the program on an
+ * in-process OpenLCB bus as fast as possible, feeding it events from a trace
+ * file or random ones, and prints the events the automatas produce.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "openlcb/EventHandlerTemplates.hxx"
+#include "openlcb/EventService.hxx"
+#include "openlcb/If.hxx"
+#include "openlcb/SimpleNodeInfoMockUserFile.hxx"
+#include "openlcb/SimpleStack.hxx"
+#include "openlcb/WriteHelper.hxx"
+#include "src/automata_runner.h"
+#include "utils/constants.hxx"
+
+static const openlcb::NodeID NODE_ID = 0x05010101143FULL;
+openlcb::SimpleCanStack stack(NODE_ID);
+
+openlcb::MockSNIPUserFile snip_user_file(
+    "Automata simulator", "Runs the signaling logic without a layout");
+const char *const openlcb::SNIP_DYNAMIC_FILENAME =
+    openlcb::MockSNIPUserFile::snip_user_file_path;
+
+// The host has RAM to spare for the decoded rule tables.
+OVERRIDE_CONST(automata_decode_rules, 1);
+
+/// How much simulated time one run of the automatas takes. Matches the
+/// AutomataTick timer.
+static const long long RUN_PERIOD_MSEC = 100;
+/// How many runs of the automatas there are between two timer ticks.
+static const int RUNS_PER_TICK = 10;
+
+const char *program_path = nullptr;
+const char *variables_path = nullptr;
+const char *trace_path = nullptr;
+const char *output_path = nullptr;
+const char *match = "";
+double random_rate = 0;
+long long duration_sec = -1;
+unsigned seed = 1;
+
+void usage(const char *e) {
+  fprintf(stderr,
+          "Usage: %s [-f automata.bin] [-v variables.txt] [-i trace] "
+          "[-r rate [-m match] [-s seed]] [-t seconds] [-o output]\n",
+          e);
+  fprintf(stderr,
+          "Runs the automata program in simulated time as fast as possible "
+          "and prints the events it produces.\n");
+  fprintf(stderr,
+          "-f loads a rendered program instead of the one linked in.\n"
+          "-v reads event names from the variables.txt file written by the "
+          "renderer.\n"
+          "-i replays the events in trace. Each line is the simulated time "
+          "in seconds and an event id or name. The output of the simulator "
+          "is in the same format.\n"
+          "-r sends rate random events per simulated second, chosen from "
+          "the events of -v whose name contains match.\n"
+          "-t is the simulated time to run. Default is 10 seconds after the "
+          "end of the trace.\n"
+          "-o writes the produced events to output instead of stdout.\n");
+  exit(1);
+}
+
+void parse_args(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hf:v:i:r:m:s:t:o:")) >= 0) {
+    switch (opt) {
+      case 'h':
+        usage(argv[0]);
+        break;
+      case 'f':
+        program_path = optarg;
+        break;
+      case 'v':
+        variables_path = optarg;
+        break;
+      case 'i':
+        trace_path = optarg;
+        break;
+      case 'r':
+        random_rate = atof(optarg);
+        break;
+      case 'm':
+        match = optarg;
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case 't':
+        duration_sec = atoll(optarg);
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      default:
+        fprintf(stderr, "Unknown option %c\n", opt);
+        usage(argv[0]);
+    }
+  }
+  if (random_rate > 0 && !variables_path) {
+    fprintf(stderr, "Random events need the event names from -v.\n");
+    usage(argv[0]);
+  }
+}
+
+extern char automata_code[];
+
+/// Event names from variables.txt.
+std::map<uint64_t, string> event_names;
+/// Current simulated time. Only changed while the event processing is
+/// drained, so the executor thread always prints the time of the current run.
+long long sim_msec = 0;
+FILE *output = stdout;
+
+void read_variables(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+    exit(1);
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char *end;
+    uint64_t id = strtoull(line, &end, 16);
+    if (end == line || *end != ':') continue;
+    ++end;
+    while (*end == ' ') ++end;
+    end[strcspn(end, "\r\n")] = 0;
+    event_names[id] = end;
+  }
+  fclose(f);
+}
+
+/// @return the event id from a trace, which is either a hex number (dots
+/// allowed between the bytes) or the name of an event from variables.txt.
+uint64_t parse_event(const char *s) {
+  string hex;
+  for (const char *p = s; *p; ++p) {
+    if (*p != '.') hex.push_back(*p);
+  }
+  char *end;
+  uint64_t id = strtoull(hex.c_str(), &end, 16);
+  if (!hex.empty() && !*end) return id;
+  for (const auto &it : event_names) {
+    if (it.second == s) return it.first;
+  }
+  fprintf(stderr, "Unknown event %s\n", s);
+  exit(1);
+}
+
+struct TraceEntry {
+  long long msec;
+  uint64_t event_id;
+};
+
+std::vector<TraceEntry> read_trace(const char *path) {
+  std::vector<TraceEntry> ret;
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+    exit(1);
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    double sec;
+    char event[128];
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%lf %127s", &sec, event) != 2) continue;
+    ret.push_back({(long long)(sec * 1000), parse_event(event)});
+  }
+  fclose(f);
+  return ret;
+}
+
+void print_event(uint64_t event_id) {
+  fprintf(output, "%lld.%03lld %016" PRIx64, sim_msec / 1000, sim_msec % 1000,
+          event_id);
+  auto it = event_names.find(event_id);
+  if (it != event_names.end()) {
+    fprintf(output, " %s", it->second.c_str());
+  }
+  fprintf(output, "\n");
+}
+
+/// Prints every event produced on the bus, except the ones we inject.
+class EventRecorder : public openlcb::SimpleEventHandler {
+ public:
+  EventRecorder() {
+    openlcb::EventRegistry::instance()->register_handler(
+        openlcb::EventRegistryEntry(this, 0), 64);
+  }
+
+  ~EventRecorder() {
+    openlcb::EventRegistry::instance()->unregister_handler(this);
+  }
+
+  void handle_event_report(const openlcb::EventRegistryEntry &entry,
+                           openlcb::EventReport *event,
+                           BarrierNotifiable *done) override {
+    AutoNotify an(done);
+    {
+      OSMutexLock l(&lock_);
+      auto it = pendingInjected_.find(event->event);
+      if (it != pendingInjected_.end()) {
+        // This is the loopback of an event we injected.
+        pendingInjected_.erase(it);
+        return;
+      }
+    }
+    print_event(event->event);
+    ++num_events_;
+  }
+
+  /// Sends an event to the automatas. Call drain() before running the
+  /// automatas to make sure they have seen it.
+  void inject(uint64_t event_id) {
+    SyncNotifiable n;
+    {
+      OSMutexLock l(&lock_);
+      pendingInjected_.insert(event_id);
+    }
+    helper_.WriteAsync(stack.node(), openlcb::Defs::MTI_EVENT_REPORT,
+                       openlcb::WriteHelper::global(),
+                       openlcb::eventid_to_buffer(event_id), &n);
+    n.wait_for_notification();
+  }
+
+  unsigned num_events() { return num_events_; }
+
+ private:
+  openlcb::WriteHelper helper_;
+  /// Protects pendingInjected_.
+  OSMutex lock_;
+  /// Events we injected that did not come back to the handlers yet.
+  std::multiset<uint64_t> pendingInjected_;
+  unsigned num_events_{0};
+};
+
+/// Waits until the executor has delivered all events that are on their way
+/// to the event handlers, including the ones sent by the automatas.
+void drain() {
+  do {
+    stack.node()->iface()->executor()->sync_run([]() {});
+  } while (openlcb::EventService::instance->event_processing_pending());
+}
+
+int appl_main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+  if (variables_path) read_variables(variables_path);
+  std::vector<TraceEntry> trace;
+  if (trace_path) trace = read_trace(trace_path);
+  std::vector<uint64_t> random_events;
+  for (const auto &it : event_names) {
+    if (it.second.find(match) != string::npos) {
+      random_events.push_back(it.first);
+    }
+  }
+  if (random_rate > 0 && random_events.empty()) {
+    fprintf(stderr, "No events match %s\n", match);
+    exit(1);
+  }
+  string program;
+  if (program_path) {
+    FILE *f = fopen(program_path, "rb");
+    if (!f) {
+      fprintf(stderr, "Cannot open %s: %s\n", program_path, strerror(errno));
+      exit(1);
+    }
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) program.append(buf, len);
+    fclose(f);
+  }
+  if (output_path) {
+    output = fopen(output_path, "w");
+    if (!output) {
+      fprintf(stderr, "Cannot open %s: %s\n", output_path, strerror(errno));
+      exit(1);
+    }
+  }
+  long long end_msec = duration_sec * 1000;
+  if (duration_sec < 0) {
+    end_msec = (trace.empty() ? 0 : trace.back().msec) + 10000;
+  }
+
+  stack.start_executor_thread("stack", 0, 0);
+  while (!stack.node()->is_initialized()) {
+    usleep(1000);
+  }
+  EventRecorder recorder;
+  AutomataRunner runner(stack.node(),
+                        program_path ? (const insn_t *)program.data()
+                                     : (const insn_t *)automata_code,
+                        false);
+  runner.QueryBitStates();
+  drain();
+
+  long long start = os_get_time_monotonic();
+  size_t next_trace = 0;
+  unsigned num_injected = 0;
+  unsigned num_runs = 0;
+  double random_budget = 0;
+  for (; sim_msec < end_msec; sim_msec += RUN_PERIOD_MSEC) {
+    while (next_trace < trace.size() && trace[next_trace].msec <= sim_msec) {
+      recorder.inject(trace[next_trace++].event_id);
+      ++num_injected;
+    }
+    random_budget += random_rate * RUN_PERIOD_MSEC / 1000;
+    for (; random_budget >= 1; random_budget -= 1) {
+      recorder.inject(random_events[rand_r(&seed) % random_events.size()]);
+      ++num_injected;
+    }
+    // The automatas have to see the injected events before they run.
+    drain();
+    if (++num_runs % RUNS_PER_TICK == 0) {
+      for (auto *aut : runner.GetAllAutomatas()) {
+        aut->Tick();
+      }
+    }
+    runner.RunAllAutomata();
+    // The events produced have to be printed with this run's time.
+    drain();
+  }
+  long long wall_nsec = os_get_time_monotonic() - start;
+  if (output != stdout) fclose(output);
+
+  double wall_sec = wall_nsec / 1e9;
+  fprintf(stderr,
+          "Simulated %lld sec in %.3f sec (%.0fx real time), %u runs of %zu "
+          "automatas.\n",
+          end_msec / 1000, wall_sec, end_msec / 1000.0 / wall_sec, num_runs,
+          runner.GetAllAutomatas().size());
+  fprintf(stderr,
+          "Evaluated %u automatas (%u skipped) and %" PRIu64
+          " rules, %.0f rules/sec.\n",
+          runner.GetEvaluatedRuns(), runner.GetSkippedRuns(),
+          runner.GetEvaluatedRules(), runner.GetEvaluatedRules() / wall_sec);
+  fprintf(stderr, "%u events in, %u events out.\n", num_injected,
+          recorder.num_events());
+  return 0;
+}
@@ -87,6 +87,8 @@ CDI_GROUP_ENTRY(userinfo, UserInfoSegment);
 CDI_GROUP_ENTRY(seg, IoBoardSegment);
 /// Adds the versioning segment.
 CDI_GROUP_ENTRY(version, VersionSeg);
+/// Adds the read-only execution profile of the logic blocks.
+CDI_GROUP_ENTRY(logic_profile, logic::LogicProfileSegment);
 CDI_GROUP_END();
 
 } // namespace openlcb
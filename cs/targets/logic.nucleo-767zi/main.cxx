@@ -57,6 +57,7 @@
 #include "i2c-dev.h"
 
 #include "logic/OlcbBindings.hxx"
+#include "logic/OlcbProfileSpace.hxx"
 
 // These preprocessor symbols are used to select which physical connections
 // will be enabled in the main(). See @ref appl_main below.
@@ -244,6 +245,9 @@ openlcb::RefreshLoop loopab(stack.node(),
 
 // =============== LOGIC BLOCKS ===================
 logic::OlcbVariableFactory logic_blocks(stack.node(), cfg.seg().logic());
+// Exports the execution profile of the logic blocks for the config tool.
+logic::LogicProfileSpace logic_profile(
+    stack.memory_config_handler(), logic_blocks.runner(), stack.node());
 
 
 /** Entry point to application.
@@ -256,6 +260,9 @@ int appl_main(int argc, char *argv[])
     stack.create_config_file_if_needed(cfg.seg().internal_config(),
                                        openlcb::CANONICAL_VERSION,
                                        openlcb::CONFIG_FILE_SIZE);
+    // Compiled logic blocks are kept here so that unchanged blocks need not
+    // be compiled again at boot.
+    logic_blocks.runner()->set_cache_file("/ffs/logiccache");
 
 #if 0 &&(NUM_EXTBOARDS > 0)
     {
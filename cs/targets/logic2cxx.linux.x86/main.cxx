@@ -0,0 +1,122 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Translates a logic block to C++ source code ahead of time.
+ *
+ * The output is a translation unit that can be linked into a binary with
+ * the logic runner, or compiled into a shared object and loaded with
+ * Runner::set_native_library(). The translated code is used only for a block
+ * whose compiled bytecode is exactly the same as what it was translated from;
+ * other blocks run in the VM.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "logic/CxxTranslator.hxx"
+#include "logic/Driver.hxx"
+#include "utils/FileUtils.hxx"
+
+/// Logic block number the source is compiled for.
+unsigned block_num = 0;
+/// Where to write the generated code. Empty for stdout.
+std::string output_file;
+/// Source file of the logic block.
+std::string input_file;
+
+void usage(const char *e) {
+  fprintf(stderr, "Usage: %s [-b block] [-o output.cxx] input\n\n", e);
+  fprintf(stderr,
+          "Compiles a logic block and translates it to C++.\n\n"
+          "\t-b block is the number of the logic block that will run this "
+          "code (default 0). The compiled code depends on it.\n"
+          "\t-o output.cxx is the file to write the generated code to. "
+          "Defaults to stdout.\n");
+  exit(1);
+}
+
+void parse_args(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hb:o:")) >= 0) {
+    switch (opt) {
+      case 'h':
+        usage(argv[0]);
+        break;
+      case 'b':
+        block_num = atoi(optarg);
+        break;
+      case 'o':
+        output_file = optarg;
+        break;
+      default:
+        fprintf(stderr, "Unknown option %c\n", opt);
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+  }
+  input_file = argv[optind];
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 upon success.
+ */
+int appl_main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+  std::string source = read_file_to_string(input_file);
+
+  // Same settings as the logic runner, which yields the same bytecode.
+  logic::Driver driver;
+  driver.set_line_info(true);
+  driver.set_guid_start(block_num << 16);
+  if (driver.parse_string(source) != 0) {
+    fprintf(stderr, "Compile failed.\n%s", driver.error_output_.c_str());
+    return 1;
+  }
+  std::string bytecode;
+  driver.serialize(&bytecode);
+
+  std::string output;
+  if (!logic::CxxTranslator::translate(bytecode, &output)) {
+    fprintf(stderr, "The bytecode cannot be translated.\n");
+    return 1;
+  }
+  if (output_file.empty()) {
+    fwrite(output.data(), 1, output.size(), stdout);
+  } else {
+    write_string_to_file(output_file, output);
+  }
+  return 0;
+}
@@ -0,0 +1,479 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Micro-benchmarks for the logic language virtual machine and compiler.
+ *
+ * The output is a CSV table on stdout with the columns
+ * suite,benchmark,engine,unit,value; one row per measurement. Compare the
+ * output of two revisions to find regressions in the interpreter.
+ *
+ * @author Balazs Racz
+ * @date 17 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "logic/Bytecode.hxx"
+#include "logic/Driver.hxx"
+#include "logic/MockVariable.hxx"
+#include "logic/VM.hxx"
+#include "logic/Variable.hxx"
+#include "os/os.h"
+#include "utils/StringPrintf.hxx"
+
+using ::testing::Mock;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+
+using namespace logic;
+
+/// How many times the loop body is repeated in the bytecode of one loop
+/// iteration. Amortizes the cost of the loop counter.
+static constexpr unsigned BODY_REPEAT = 10;
+
+/// Number of instructions in the loop counter code (per iteration).
+static constexpr unsigned LOOP_INSNS = 6;
+
+/// Byte offset of the RET instruction at the beginning of every benchmark
+/// block; this is the target of the CALL benchmark.
+static constexpr int FUNCTION_ADDRESS = 2;
+
+/// GUID of the external and static variables in the benchmark code.
+static constexpr int VAR_GUID = 1;
+
+/// Number of loop iterations to run the VM benchmarks for.
+unsigned num_iterations = 100000;
+/// Number of times to repeat each measurement. The fastest run is reported.
+unsigned num_repeats = 5;
+/// Approximate size of the source code in the compiler benchmarks.
+unsigned source_kbytes = 16;
+
+/// Appends an instruction without operand.
+static void op(std::string* c, OpCode opcode) {
+  BytecodeStream::append_opcode(c, opcode);
+}
+
+/// Appends an instruction with a varint operand.
+static void op(std::string* c, OpCode opcode, int arg) {
+  BytecodeStream::append_opcode(c, opcode);
+  BytecodeStream::append_varint(c, arg);
+}
+
+/// One VM benchmark. The code is a loop with the counter at fp+0. The setup
+/// code may push further values to the operand stack (fp+1, ...). The body
+/// shall leave the operand stack unchanged.
+struct VMKernel {
+  /// Name in the output.
+  const char* name;
+  /// Emits the code to run before the loop. May be nullptr.
+  void (*setup)(std::string* c);
+  /// Emits one copy of the loop body.
+  void (*body)(std::string* c);
+  /// Number of instructions executed by one copy of the body.
+  unsigned body_insns;
+  /// Number of external variable reads in one copy of the body.
+  unsigned body_reads;
+  /// Number of external variable writes in one copy of the body.
+  unsigned body_writes;
+};
+
+/// Creates a local variable at fp+1 and a reference to it at fp+2.
+static void setup_indirect(std::string* c) {
+  op(c, PUSH_CONSTANT_0);
+  op(c, CREATE_INDIRECT_VAR, 1);
+}
+
+/// Creates a static variable in slot 0.
+static void setup_static(std::string* c) {
+  op(c, INIT_STATIC, 0);
+  op(c, POP_OP);
+}
+
+/// Creates a static variable in slot 0; a reference to it is at fp+1.
+static void setup_static_ref(std::string* c) {
+  setup_static(c);
+  op(c, CREATE_INDIRECT_STATIC, 0);
+}
+
+/// Creates an exported variable via the variable factory; the reference is
+/// at fp+1.
+static void setup_external(std::string* c) {
+  op(c, LOAD_STRING);
+  BytecodeStream::append_string(c, "bench");
+  op(c, CREATE_VAR, VAR_GUID);
+  BytecodeStream::append_varint(c, -1);
+  op(c, PUSH_CONSTANT, VAR_GUID);
+  op(c, PUSH_CONSTANT_0);
+  op(c, IMPORT_VAR);
+}
+
+static void body_empty(std::string* c) {}
+
+static void body_arith(std::string* c) {
+  op(c, LOAD_FP_REL, 0);
+  op(c, PUSH_CONSTANT, 3);
+  op(c, NUMERIC_PLUS);
+  op(c, PUSH_CONSTANT, 7);
+  op(c, NUMERIC_MUL);
+  op(c, PUSH_CONSTANT, 5);
+  op(c, NUMERIC_MINUS);
+  op(c, PUSH_CONSTANT, 3);
+  op(c, NUMERIC_DIV);
+  op(c, POP_OP);
+}
+
+static void body_compare(std::string* c) {
+  op(c, LOAD_FP_REL, 0);
+  op(c, PUSH_CONSTANT, 100);
+  op(c, NUMERIC_LT);
+  op(c, LOAD_FP_REL, 0);
+  op(c, PUSH_CONSTANT, 5);
+  op(c, NUMERIC_GEQ);
+  op(c, BOOL_EQ);
+  op(c, BOOL_NOT);
+  op(c, POP_OP);
+}
+
+static void body_call(std::string* c) {
+  op(c, PUSH_CONSTANT, FUNCTION_ADDRESS);
+  op(c, CALL, 0);
+}
+
+/// Increments the variable whose reference is at fp+`ofs`.
+static void increment_indirect(std::string* c, int ofs) {
+  op(c, LOAD_FP_REL, ofs);
+  op(c, INDIRECT_LOAD);
+  op(c, PUSH_CONSTANT_1);
+  op(c, NUMERIC_PLUS);
+  op(c, LOAD_FP_REL, ofs);
+  op(c, INDIRECT_STORE);
+}
+
+static void body_indirect(std::string* c) {
+  increment_indirect(c, 2);
+}
+
+static void body_static(std::string* c) {
+  op(c, LOAD_STATIC, 0);
+  op(c, PUSH_CONSTANT_1);
+  op(c, NUMERIC_PLUS);
+  op(c, STORE_STATIC, 0);
+}
+
+static void body_static_ref(std::string* c) {
+  increment_indirect(c, 1);
+}
+
+static void body_external(std::string* c) {
+  op(c, LOAD_FP_REL, 1);
+  op(c, INDIRECT_LOAD);
+  op(c, BOOL_NOT);
+  op(c, LOAD_FP_REL, 1);
+  op(c, INDIRECT_STORE);
+}
+
+static const VMKernel kernels[] = {
+    {"loop", nullptr, &body_empty, 0, 0, 0},
+    {"arith", nullptr, &body_arith, 10, 0, 0},
+    {"compare", nullptr, &body_compare, 9, 0, 0},
+    {"call_ret", nullptr, &body_call, 3, 0, 0},
+    {"indirect_local", &setup_indirect, &body_indirect, 6, 0, 0},
+    {"static_var", &setup_static, &body_static, 4, 0, 0},
+    {"static_ref", &setup_static_ref, &body_static_ref, 6, 0, 0},
+    {"external_var", &setup_external, &body_external, 5, 1, 1},
+};
+
+/// Renders the bytecode for a benchmark kernel.
+/// @param k is the kernel to render.
+/// @param iterations is how many times the loop should run.
+/// @return the bytecode of the block.
+std::string build_kernel(const VMKernel& k, unsigned iterations) {
+  std::string c;
+  // The function called by the call_ret benchmark.
+  op(&c, JUMP, 1);
+  HASSERT(c.size() == FUNCTION_ADDRESS);
+  op(&c, RET);
+
+  op(&c, PUSH_CONSTANT, iterations);
+  if (k.setup) k.setup(&c);
+  int loop_start = c.size();
+  for (unsigned i = 0; i < BODY_REPEAT; ++i) {
+    k.body(&c);
+  }
+  op(&c, LOAD_FP_REL, 0);
+  op(&c, PUSH_CONSTANT_1);
+  op(&c, NUMERIC_MINUS);
+  op(&c, PUSH_TOP);
+  op(&c, STORE_FP_REL, 0);
+  int jump_ofs = c.size();
+  op(&c, TEST_JUMP_IF_TRUE);
+  // The jump is relative to the end of the operand, whose length depends on
+  // the jump distance.
+  for (unsigned len = 1;; ++len) {
+    std::string arg;
+    BytecodeStream::append_varint(&arg, loop_start - (jump_ofs + 1 + len));
+    if (arg.size() == len) {
+      c += arg;
+      break;
+    }
+  }
+  return c;
+}
+
+/// Variable factory that backs every exported variable with a
+/// StaticVariable.
+class StaticVariableFactory : public VariableFactory {
+ public:
+  std::unique_ptr<Variable> create_variable(
+      VariableCreationRequest* request) override {
+    return std::unique_ptr<Variable>(new StaticVariable);
+  }
+};
+
+/// Variable factory that hands out a single, previously set variable.
+class SingleVariableFactory : public VariableFactory {
+ public:
+  std::unique_ptr<Variable> create_variable(
+      VariableCreationRequest* request) override {
+    HASSERT(next_);
+    return std::move(next_);
+  }
+
+  /// The variable to return upon the next create_variable call.
+  std::unique_ptr<Variable> next_;
+};
+
+/// Prints one row of the result table.
+void report(const char* suite, const char* benchmark, const char* engine,
+            const char* unit, double value) {
+  printf("%s,%s,%s,%s,%.3f\n", suite, benchmark, engine, unit, value);
+  fflush(stdout);
+}
+
+/// Runs a kernel once.
+/// @return the execution time in nanoseconds.
+long long run_kernel(VM* vm, const std::string& code, const VMKernel& k) {
+  vm->clear();
+  vm->set_block_code(0, code);
+  long long start = os_get_time_monotonic();
+  bool ok = vm->execute_block(0);
+  long long end = os_get_time_monotonic();
+  if (!ok) {
+    fprintf(stderr, "Benchmark %s failed: %s\n", k.name,
+            vm->get_error().c_str());
+    exit(1);
+  }
+  return end - start;
+}
+
+/// Checks on a short run that the kernel performs exactly the expected
+/// number of variable accesses. This makes sure the timings are for the
+/// instruction mix we think they are.
+void verify_kernel(const VMKernel& k, bool predecode) {
+  if (!k.body_reads && !k.body_writes) return;
+  static constexpr unsigned kIterations = 100;
+  unsigned reads = kIterations * BODY_REPEAT * k.body_reads;
+  unsigned writes = kIterations * BODY_REPEAT * k.body_writes;
+  SingleVariableFactory factory;
+  auto* m = new StrictMock<MockVariable>();
+  factory.next_.reset(m);
+  EXPECT_CALL(*m, read(_, _)).Times(reads).WillRepeatedly(Return(0));
+  EXPECT_CALL(*m, write(_, _, _)).Times(writes);
+  VM vm(&factory);
+  vm.set_predecode(predecode);
+  vm.clear();
+  vm.set_block_code(0, build_kernel(k, kIterations));
+  bool ok = vm.execute_block(0);
+  if (!ok || !Mock::VerifyAndClearExpectations(m)) {
+    fprintf(stderr, "Benchmark %s: verification failed. %s\n", k.name,
+            vm.get_error().c_str());
+    exit(1);
+  }
+}
+
+/// Runs all VM benchmarks with one execution engine.
+/// @param predecode true for the pre-decoded engine, false for the bytecode
+/// interpreter.
+void run_vm_benchmarks(bool predecode) {
+  const char* engine = predecode ? "decoded" : "switch";
+  double loop_ns_per_iteration = 0;
+  for (const auto& k : kernels) {
+    verify_kernel(k, predecode);
+    StaticVariableFactory factory;
+    VM vm(&factory);
+    vm.set_predecode(predecode);
+    std::string code = build_kernel(k, num_iterations);
+    long long best = -1;
+    for (unsigned r = 0; r < num_repeats; ++r) {
+      long long t = run_kernel(&vm, code, k);
+      if (best < 0 || t < best) best = t;
+    }
+    double ns_per_iteration = double(best) / num_iterations;
+    unsigned insns = BODY_REPEAT * k.body_insns + LOOP_INSNS;
+    report("vm", k.name, engine, "ns_per_insn", ns_per_iteration / insns);
+    if (!k.body_insns) {
+      loop_ns_per_iteration = ns_per_iteration;
+      continue;
+    }
+    // Same, but without the time spent in the loop counter.
+    report("vm", k.name, engine, "ns_per_body_insn",
+           (ns_per_iteration - loop_ns_per_iteration) /
+               (BODY_REPEAT * k.body_insns));
+  }
+}
+
+/// Generates source code for the compiler benchmarks.
+/// @param kind selects the flavor of the source code.
+/// @param kbytes is the approximate desired size of the source.
+/// @return source code of a logic block.
+std::string generate_source(const char* kind, unsigned kbytes) {
+  std::string s;
+  unsigned i = 0;
+  if (!strcmp(kind, "functions")) {
+    s = "void inc(mutable int x) { x = x + 1; }\n";
+  }
+  while (s.size() < kbytes * 1024) {
+    if (!strcmp(kind, "expressions")) {
+      s += StringPrintf("int a%u = (%u * 3 + 7) %% 11 - %u / 2;\n", i, i, i);
+    } else if (!strcmp(kind, "control")) {
+      s += StringPrintf(
+          "int c%u = %u;\nif (c%u > 3 && c%u < 100) { c%u = c%u * 2; } "
+          "else { c%u = 0; }\n",
+          i, i, i, i, i, i, i);
+    } else if (!strcmp(kind, "exported")) {
+      s += StringPrintf("exported bool e%u;\ne%u = !e%u;\n", i, i, i);
+    } else {
+      s += StringPrintf("int f%u = %u;\ninc(&f%u);\n", i, i, i);
+    }
+    ++i;
+  }
+  return s;
+}
+
+/// Runs the compiler benchmarks.
+/// @param optimize whether the bytecode optimizer should run.
+void run_compiler_benchmarks(bool optimize) {
+  const char* engine = optimize ? "optimized" : "unoptimized";
+  static const char* const kinds[] = {
+      "expressions", "control", "exported", "functions"};
+  for (const char* kind : kinds) {
+    std::string source = generate_source(kind, source_kbytes);
+    Driver driver;
+    driver.set_optimize(optimize);
+    std::string bytecode;
+    long long best = -1;
+    for (unsigned r = 0; r < num_repeats; ++r) {
+      bytecode.clear();
+      driver.clear();
+      long long start = os_get_time_monotonic();
+      int ret = driver.parse_string(source);
+      if (ret == 0) {
+        driver.serialize(&bytecode);
+      }
+      long long end = os_get_time_monotonic();
+      if (ret != 0 || !driver.error_output_.empty()) {
+        fprintf(stderr, "Compiling %s failed: %s\n", kind,
+                driver.error_output_.c_str());
+        exit(1);
+      }
+      if (best < 0 || end - start < best) best = end - start;
+    }
+    double kbytes = source.size() / 1024.0;
+    report("compiler", kind, engine, "ms_per_kb", best / 1e6 / kbytes);
+    report("compiler", kind, engine, "bytecode_bytes_per_kb",
+           bytecode.size() / kbytes);
+  }
+}
+
+void usage(const char *e) {
+  fprintf(stderr, "Usage: %s [-n iterations] [-r repeats] [-s kbytes]\n\n",
+          e);
+  fprintf(stderr,
+          "Runs micro-benchmarks of the logic language VM and compiler, and "
+          "prints the results as CSV to stdout.\n\nArguments:\n");
+  fprintf(stderr,
+          "\t-n iterations   is the number of loop iterations in the VM "
+          "benchmarks. Default 100000.\n");
+  fprintf(stderr,
+          "\t-r repeats      is how many times each measurement is repeated. "
+          "The fastest is reported. Default 5.\n");
+  fprintf(stderr,
+          "\t-s kbytes       is the size of the source code in the compiler "
+          "benchmarks. Default 16.\n");
+  exit(1);
+}
+
+void parse_args(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:r:s:")) >= 0) {
+    switch (opt) {
+      case 'h':
+        usage(argv[0]);
+        break;
+      case 'n':
+        num_iterations = atoi(optarg);
+        break;
+      case 'r':
+        num_repeats = atoi(optarg);
+        break;
+      case 's':
+        source_kbytes = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "Unknown option %c\n", opt);
+        usage(argv[0]);
+    }
+  }
+  if (!num_iterations || !num_repeats || !source_kbytes) {
+    fprintf(stderr, "Arguments must be positive.\n");
+    usage(argv[0]);
+  }
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 after all benchmarks ran.
+ */
+int appl_main(int argc, char *argv[]) {
+  ::testing::InitGoogleMock(&argc, argv);
+  parse_args(argc, argv);
+  printf("suite,benchmark,engine,unit,value\n");
+  run_vm_benchmarks(true);
+  run_vm_benchmarks(false);
+  run_compiler_benchmarks(true);
+  run_compiler_benchmarks(false);
+  return 0;
+}